@@ -26,6 +26,8 @@ namespace fd
 
     static const int CNT_VALID_ACK = 3;   // number of acknowledgements to be considered valid
     static const int PERIOD_TEXT = 10000; // 10-sec period for switching between multiple text
+    static const int PERIOD_KEEP_ALIVE = 60000; // refresh of unchanged content in change-only mode
+    static const int PERIOD_CHECKPOINT = 10000; // checkpoint of the running test
 
     static const QString FlurdisplaySection = "flurdisplay";
     static const QString DeviceSection = "device";
@@ -82,6 +84,53 @@ namespace fd
     static const QString RulesMatchAddrList = "addrList";
     static const QString RulesMatchAddrListStations = "stations";
     static const QString RulesMatchAddrListSupervisors = "supervisors";
+    static const QString RulesChangeOnly = "changeOnly";    // keep-alive period in ms, true: default period
+    static const QString RulesCoverage = "coverage";
+        static const QString RulesCoverageNone = "none";
+        static const QString RulesCoverageFull = "full";
+        static const QString RulesCoveragePairwise = "pairwise";
+
+    // test script
+    static const QString ScriptName = "name";
+    static const QString ScriptSteps = "steps";
+    static const QString ScriptStep = "step";
+        static const QString ScriptStepSend = "send";
+        static const QString ScriptStepWaitAck = "waitAck";
+        static const QString ScriptStepWait = "wait";
+        static const QString ScriptStepCommand = "command";
+        static const QString ScriptStepBaud = "baud";
+        static const QString ScriptStepAssert = "assert";
+        static const QString ScriptStepResetCounters = "resetCounters";
+        static const QString ScriptStepLoop = "loop";
+    static const QString ScriptPattern = "pattern";     // pattern id or "next"
+    static const QString ScriptNext = "next";
+    static const QString ScriptTimeout = "timeout";
+    static const QString ScriptTime = "ms";
+    static const QString ScriptValue = "value";
+    static const QString ScriptCount = "count";         // loop count, -1: endless
+    static const QString ScriptCounter = "counter";     // "sent", "ack", "nack", "timeout"
+    static const QString ScriptMin = "min";
+    static const QString ScriptMax = "max";
+
+    // firmware profile
+    static const QString ProfileDevice = "device";
+    static const QString ProfileFirmware = "firmware";
+    static const QString ProfileDevInterface = "devInterface";
+    static const QString ProfileDate = "date";
+    static const QString ProfileRepeat = "repeat";
+    static const QString ProfileSeries = "series";
+        static const QString ProfileCmd = "cmd";
+        static const QString ProfileLength = "length";
+        static const QString ProfileSent = "sent";
+        static const QString ProfileAck = "ack";
+        static const QString ProfileNack = "nack";
+        static const QString ProfileTimeout = "timeout";
+        static const QString ProfileLatencyMin = "latencyMinUs";
+        static const QString ProfileLatencyP50 = "latencyP50Us";
+        static const QString ProfileLatencyP90 = "latencyP90Us";
+        static const QString ProfileLatencyP99 = "latencyP99Us";
+        static const QString ProfileLatencyMax = "latencyMaxUs";
+        static const QString ProfileLatencyMean = "latencyMeanUs";
 
     // event names
     static const QString ReminderEvent ="reminder";
@@ -153,6 +202,7 @@ namespace fd
     static const int PRTY_CALL = 10;
     static const int PRTY_CALL_WC = 11;
     static const int PRTY_ALARM = 20;
+    static const int PRTY_COVERAGE = 0x100;  // generated patterns, above the priorities of the rules
 
     static const int TONE_NONE = 0x00;
     static const int TONE_CALL = 0x40;
@@ -4,10 +4,12 @@
 #
 #-------------------------------------------------
 
-QT       += core gui serialport
+QT       += core gui serialport concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
+CONFIG += c++11
+
 TARGET = fdTest
 TEMPLATE = app
 
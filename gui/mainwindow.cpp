@@ -1,6 +1,8 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "configloader.h"
 #include <QMessageBox>
+#include <QInputDialog>
 
 using namespace fd;
 
@@ -11,15 +13,25 @@ static const char* UI_TXT_TONE_ALARM = QT_TRANSLATE_NOOP("MainWindow", "alarm");
 static const char* UI_PROTOCOL_VIEW_RX = QT_TRANSLATE_NOOP("MainWindow", "RX: ");
 static const char* UI_PROTOCOL_VIEW_TX = QT_TRANSLATE_NOOP("MainWindow", "tx: ");
 
-MainWindow::MainWindow(QJsonObject configOptions, QJsonObject testPatterns, QWidget *parent) :
+MainWindow::MainWindow(QJsonObject configOptions, QJsonObject testPatterns,
+                       const TestPatternGenerator &testRules, QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow)
 {
-    ui->setupUi(this);
+    // test setup is loaded in background while the widgets are created
+    QJsonObject config;
+    QFuture<bool> loading;
+    bool isConfigFile = QFile::exists(configFileName);
+
+    if (isConfigFile)
+        loading = ConfigLoader::loadAsync(configFileName, &config, &mTestRules);
 
-    mSetupWizard = new SetupWizard(configOptions);
+    ui->setupUi(this);
 
-    connect(mSetupWizard, SIGNAL(accepted()), this, SLOT(onSetupAccepted()));
+    mSetupWizard = 0;
+    mConfigOptions = configOptions;
+    PortEnumerator::instance()->watch();    // port list of the wizard follows hot-plug
+    PortEnumerator::instance()->refresh();  // ports are ready when the wizard is opened
 
     mSerialPort = new QSerialPort(this);
     connect(mSerialPort, SIGNAL(baudRateChanged(qint32,QSerialPort::Directions)), this, SLOT(adjustSerialDataRate()));
@@ -27,41 +39,24 @@ MainWindow::MainWindow(QJsonObject configOptions, QJsonObject testPatterns, QWid
     connect(mSerialPort, SIGNAL(parityChanged(QSerialPort::Parity)), this, SLOT(adjustSerialFrame()));
     connect(mSerialPort, SIGNAL(stopBitsChanged(QSerialPort::StopBits)), this, SLOT(adjustSerialFrame()));
 
-    QFile configFile;
-
-    configFile.setFileName(configFileName);
-
-    if(configFile.exists())
+    if (isConfigFile)
     {
-        QJsonParseError parseError;
-
-        configFile.open(QFile::ReadOnly);
-        QByteArray jsonData = configFile.readAll();
-        configFile.close();
-
-        QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonData,&parseError);
-
-        if(parseError.error)
+        if (loading.result())
         {
-            int line =jsonData.left(parseError.offset).count('\n');
             qDebug()<<"###########################################";
-            qDebug()<<"Error in "+configFile.fileName()+" at line "<<line;
-            qDebug()<<parseError.errorString();
+            qDebug()<<"Error in "+configFileName;
             exit(1);
         }
-        if (jsonDoc.isObject())
-        {
-            mCfgFlurdisplay = jsonDoc.object()[FlurdisplaySection].toObject();
-            mCfgTest = jsonDoc.object()[RulesSection].toObject();
 
-            configSerialPort(mCfgFlurdisplay[HostInterfaceSection].toObject()); // update host interface
-        }
-        else
-            qDebug() << configFile.fileName() << " is not a JSON object";
+        mCfgFlurdisplay = config[FlurdisplaySection].toObject();
+        mCfgTest = config[RulesSection].toObject();
+
+        configSerialPort(mCfgFlurdisplay[HostInterfaceSection].toObject()); // update host interface
     }
     else
     {
         mCfgTest = testPatterns[RulesSection].toObject();
+        mTestRules = testRules;
 
         ui->startStopButton->setEnabled(false); // disable "Start/Stop" button
 
@@ -73,25 +68,24 @@ MainWindow::MainWindow(QJsonObject configOptions, QJsonObject testPatterns, QWid
     mSerialProtocol = new SerialProtocol;
     mSerialProtocol->setDevice(mSerialPort);
 
-    mTestManager = new TestManager(mSerialProtocol, mCfgFlurdisplay, mCfgTest);
+    mTestManager = new TestManager(mSerialProtocol, mCfgFlurdisplay, mCfgTest, &mTestRules);
 
     //connect(mTestManager, SIGNAL(testStarted()), this, SLOT(onTestStarted()));
     //connect(mTestManager, SIGNAL(testStopped()), this, SLOT(onTestStopped()));
     connect(mTestManager, SIGNAL(protocolSent(QByteArray)), this, SLOT(onProtocolSent(QByteArray)));
     connect(mTestManager, SIGNAL(dummyProtocolSent()), this, SLOT(onDummyProtocolSent()));
 
-    mBlinkTimer = new QTimer;
-    mBlinkTimer->setInterval(UI_PERIOD_BLINK);
-    connect(mBlinkTimer, SIGNAL(timeout()), this, SLOT(onBlinkTimerTimeout()));
+    mRunRecorder = new RunRecorder(mSerialProtocol, this);
+    mResults.open(ResultsStore::defaultDir());  // test history is optional, warning only
 
-    mSlidingTimer = new QTimer;
-    mSlidingTimer->setInterval(UI_SLIDING_CHAR_RATE);
-    connect(mSlidingTimer, SIGNAL(timeout()), this, SLOT(onSlidingTimerTimeout()));
+    mCheckpointTimer = new QTimer(this);
+    mCheckpointTimer->setInterval(PERIOD_CHECKPOINT);
+    connect(mCheckpointTimer, SIGNAL(timeout()), this, SLOT(onCheckpointTimeout()));
 
-    mSlidingDelayTimer = new QTimer;
-    mSlidingDelayTimer->setSingleShot(true);
-    mSlidingDelayTimer->setInterval(UI_SLIDING_START_DELAY);
-    connect(mSlidingDelayTimer, SIGNAL(timeout()), this, SLOT(onSlidingDelayTimerTimeout()));
+    mDisplayTimer = new QTimer(this);
+    mDisplayTimer->setSingleShot(true);
+    connect(mDisplayTimer, SIGNAL(timeout()), this, SLOT(onDisplayTimerTimeout()));
+    mDisplayClock.start();
 
     // communication widget
     connect(mSerialProtocol, SIGNAL(receivedACK()), this, SLOT(showRxAck()));
@@ -100,6 +94,7 @@ MainWindow::MainWindow(QJsonObject configOptions, QJsonObject testPatterns, QWid
     connect(mSerialProtocol, SIGNAL(receivedETX()), this, SLOT(showRxEtx()));
     connect(mSerialProtocol, SIGNAL(receivedEOT()), this, SLOT(showRxEot()));
     connect(mSerialProtocol, SIGNAL(sent(QByteArray)), this, SLOT(showTxBytes(QByteArray)));
+    connect(mSerialProtocol, SIGNAL(sentFrame(QByteArray)), this, SLOT(showTxFrame(QByteArray)));
 
     onTestStopped();
 }
@@ -109,21 +104,52 @@ MainWindow::~MainWindow()
     delete ui;
 }
 
+// return true on errors
+bool MainWindow::setFrameCorpus(const QString &fileName)
+{
+    if (mFrameCorpus.open(fileName) || mTestManager->setCorpus(&mFrameCorpus))
+    {
+        QMessageBox::critical(this, tr("Error"), tr("Frame corpus cannot be used: ") + fileName);
+        mFrameCorpus.close();
+        return true;
+    }
+
+    qDebug() << "frame corpus" << fileName << ":" << mFrameCorpus.count() << "frames";
+    return false;
+}
+
 void MainWindow::on_configButton_clicked()
 {
     if (mTestManager && mTestManager->isTestActive())
     {
         mTestManager->stop();
+        mRunRecorder->stop();
         onTestStopped();
     }
 
-    if (mSetupWizard)
+    if (setupWizard())
     {
         mSetupWizard->restart();
         mSetupWizard->show();
     }
 }
 
+// wizard with all its pages is built on first use, not to delay the startup
+SetupWizard *MainWindow::setupWizard()
+{
+    if (!mSetupWizard)
+    {
+        QElapsedTimer elapsed;
+
+        elapsed.start();
+        mSetupWizard = new SetupWizard(mConfigOptions);
+        connect(mSetupWizard, SIGNAL(accepted()), this, SLOT(onSetupAccepted()));
+        qDebug() << "setup wizard created in" << elapsed.elapsed() << "ms";
+    }
+
+    return mSetupWizard;
+}
+
 void MainWindow::on_startStopButton_clicked()
 {
     if (mTestManager)
@@ -131,22 +157,130 @@ void MainWindow::on_startStopButton_clicked()
         if (mTestManager->isTestActive())
         {
             mTestManager->stop();
+            mRunRecorder->stop();
             onTestStopped();
         }
         else
         {
             if (mSerialPort->portName().isEmpty())
-                if (configSerialPort(mSetupWizard->configDev()[HostInterfaceSection].toObject()))    // cannot configure port
+                if (configSerialPort(mCfgFlurdisplay[HostInterfaceSection].toObject()))    // cannot configure port
                     return;
 
             if (openSerialPort())   // cannot open port
                 return;
             onTestStarted();
-            mTestManager->start();
+
+            if (resumeTest())   // new test
+            {
+                mRunRecorder->start();
+                mTestManager->start();
+                mCheckpoint.create(CheckpointJournal::defaultFile(), mTestManager->fingerprint());
+            }
+
+            mCheckpointTimer->start();
         }
     }
 }
 
+// resume the test interrupted at the last checkpoint, return true if a new test is to be started
+bool MainWindow::resumeTest()
+{
+    CheckpointJournal::sState state;
+    QVector<sFrameMetric> frames;
+
+    if (mCheckpoint.open(CheckpointJournal::defaultFile(), mTestManager->fingerprint(), state, frames))
+        return true;
+
+    QString text = tr("A test started at %1 was interrupted after %2 min. Resume the test?")
+            .arg(QDateTime::fromMSecsSinceEpoch(state.start).toString(Qt::SystemLocaleShortDate))
+            .arg(state.elapsed / 60000);
+
+    if (QMessageBox::question(this, tr("Resume test"), text, QMessageBox::Yes | QMessageBox::No) != QMessageBox::Yes)
+        return true;
+
+    sRunResult run;
+
+    run.start = QDateTime::fromMSecsSinceEpoch(state.start);
+    run.duration = state.elapsed;
+    run.sent = state.sent;
+    run.ack = state.ack;
+    run.nack = state.nack;
+    run.frames = frames;
+
+    if (mTestManager->resume(state.id, state.cmd))
+    {
+        qWarning() << "cannot resume test at pattern" << state.id;
+        return true;
+    }
+
+    mRunRecorder->resume(run);
+    return false;
+}
+
+void MainWindow::onCheckpointTimeout()
+{
+    if (!mTestManager->isTestActive() || !mRunRecorder->isRunning())
+        return;
+
+    sRunResult run = mRunRecorder->result();
+    CheckpointJournal::sState state;
+
+    state.id = mTestManager->currentPattern();
+    state.cmd = mTestManager->command();
+    state.start = run.start.toMSecsSinceEpoch();
+    state.elapsed = mRunRecorder->elapsed();
+    state.sent = run.sent;
+    state.ack = run.ack;
+    state.nack = run.nack;
+
+    mCheckpoint.append(state, run.frames);
+}
+
+void MainWindow::on_testPassedButton_clicked()
+{
+    saveResult("passed");
+}
+
+void MainWindow::on_testFailedButton_clicked()
+{
+    saveResult("failed");
+}
+
+// stop the test and append the run with the operator verdict to the test history
+void MainWindow::saveResult(const QString &verdict)
+{
+    if (mTestManager->isTestActive())
+        mTestManager->stop();
+
+    mRunRecorder->stop();
+    onTestStopped();
+
+    bool isOk;
+    QString serial = QInputDialog::getText(this, tr("Test result"), tr("Serial number of the display:"),
+                                           QLineEdit::Normal, mLastSerial, &isOk).trimmed();
+
+    if (!isOk)
+        return;
+
+    sRunResult run = mRunRecorder->result();
+
+    run.serial = serial;
+    run.device = mCfgFlurdisplay[DeviceSection].toObject()[ConfigName].toString();
+    run.firmware = mCfgFlurdisplay[FirmwareSection].toObject()[ConfigName].toString();
+    run.devInterface = mCfgFlurdisplay[DevInterfaceSection].toObject()[ConfigName].toString();
+    run.port = mSerialPort->portName();
+    run.verdict = verdict;
+
+    if (!mResults.isOpen() || mResults.append(run))
+    {
+        QMessageBox::critical(this, tr("Error"), tr("Test result cannot be saved: ") + ResultsStore::defaultDir());
+        return;
+    }
+
+    mLastSerial = serial;
+    qDebug() << "test result" << serial << verdict << ":" << run.frames.count() << "frames";
+}
+
 void MainWindow::createConfigFile(QString fileName, QJsonObject &cfgDev, QJsonObject &cfgTestPattern)
 {
     QFile configFile;
@@ -226,6 +360,7 @@ QJsonObject MainWindow::makeDefaultTestPatterns()
     }
 
     cfgTest[RulesMatch] = rules;
+    cfgTest[RulesCoverage] = RulesCoverageNone;  // "full", "pairwise": generated coverage patterns
 
     return cfgTest;
 }
@@ -354,9 +489,10 @@ void MainWindow::onTestStarted()
 
 void MainWindow::onTestStopped()
 {
-    mBlinkTimer->stop();
-    mSlidingDelayTimer->stop();
-    mSlidingTimer->stop();
+    mCheckpointTimer->stop();
+    mCheckpoint.remove();     // test ended regularly, nothing to resume
+    mDisplayTimer->stop();
+    mDisplay.reset();
     ui->ledDisplay->clear();
     ui->indicatorMultipleText->clear();
 
@@ -382,9 +518,12 @@ void MainWindow::onSetupAccepted()
 
     createConfigFile(configFileName, mCfgFlurdisplay, mCfgTest);    // update conf file
 
-    if (mTestManager->init(mCfgFlurdisplay, mCfgTest))  // update test manager
+    if (mTestManager->init(mCfgFlurdisplay, mCfgTest, &mTestRules))  // update test manager
         qDebug() << "test manager cannot inited!";
 
+    if (mFrameCorpus.isOpen() && mTestManager->setCorpus(&mFrameCorpus))  // corpus of previous configuration
+        mFrameCorpus.close();
+
     if (!ui->startStopButton->isEnabled())              // enable test start button
         ui->startStopButton->setEnabled(true);
 }
@@ -419,11 +558,6 @@ void MainWindow::updateConfigurationLabel(QJsonObject config)
 
 void MainWindow::onProtocolSent(QByteArray byte)
 {
-    QByteArray frontText;
-    QByteArray backText;
-    char ch;
-    bool isBlinking = false;
-
     if (!mTestManager->isTestActive())
         return;
 
@@ -431,189 +565,42 @@ void MainWindow::onProtocolSent(QByteArray byte)
         return;
 
     mSentProtocol = byte;
-    mSlidingTimer->stop();
-
-    // extract text from byte protocol
-    if (byte.at(PROT_HDR_CMD) == LR_CMD_28)
-    {
-        if (byte.length() > (PROT_28_PL_DATA + byte.at(PROT_28_PL_LENGTH)))
-        {
-            frontText = byte.mid(PROT_28_PL_DATA, byte.at(PROT_28_PL_LENGTH));
-            backText = frontText;
-        }
-
-        for (int i = 0; i < frontText.length(); ++i)
-        {
-            if (frontText.at(i) & BLINK_CHAR)
-            {
-                ch = frontText.at(i) & ~BLINK_CHAR;
-                frontText[i] = ch;
-
-                backText[i] = QChar::Space;
-                isBlinking = true;
-            }
-        }
-
-        if (byte.at(PROT_28_TXT_FORMAT) & MULTIPLE_TEXT)
-            ui->indicatorMultipleText->setText(":");
-        else
-            ui->indicatorMultipleText->clear();
-
-        if (byte.at(PROT_28_TXT_FORMAT) & SLIDING_TEXT)
-        {
-            mSlidingDelayTimer->start();
-            mSlidingAndBlinking = isBlinking;
-        }
-
-        mCurrTone = UI_TXT_TONE_NONE;
-        if (byte.at(PROT_28_TONE) & TONE_CALL)
-            mCurrTone = UI_TXT_TONE_CALL;
-        else if (byte.at(PROT_28_TONE) & TONE_ALARM)
-            mCurrTone = UI_TXT_TONE_ALARM;
-    }
-    else if ((byte.at(PROT_HDR_CMD) == LR_CMD_26) ||
-             (byte.at(PROT_HDR_CMD) == LR_CMD_27))
-    {
-
-        frontText = byte.mid(PROT_26_PL_DATA, PROT_26_PL_LEN);
-        backText = frontText;
-
-        if (byte.at(PROT_HDR_CMD) == LR_CMD_26)
-        {
-            for (int i = 0; i < frontText.length(); ++i)
-            {
-                if (frontText.at(i) & BLINK_CHAR)
-                {
-                    ch = frontText.at(i) & ~BLINK_CHAR;
-                    frontText[i] = ch;
-
-                    backText[i] = QChar::Space;
-                    isBlinking = true;
-                }
-            }
-        }
-        else if (byte.at(PROT_HDR_CMD) == LR_CMD_27)
-        {
-            // blinking all or not
-            if (frontText.at(0) & BLINK_CHAR)
-            {
-                isBlinking = true;
-
-                for (int i = 0; i < frontText.length(); ++i)
-                {
-                    if (frontText.at(i) & BLINK_CHAR)
-                    {
-                        ch = frontText.at(i) & ~BLINK_CHAR;
-                        frontText[i] = ch;
-                    }
-
-                    backText[i] = QChar::Space;
-                }
-            }
-
-            // insert extra space between Rufart and Adress for command 0x27
-            QByteArray temp = frontText;
-
-            frontText = temp.left(1);
-            frontText.append(QChar::Space);
-            frontText.append(temp.mid(1));
-
-            temp = backText;
-
-            backText = temp.left(1);
-            backText.append(QChar::Space);
-            backText.append(temp.mid(1));
-        }
-
-        mCurrTone = UI_TXT_TONE_NONE;
-        uchar tone = byte.at(PROT_26_PRIORITY);
-        if (tone == PROT_26_TONE_CALL)
-            mCurrTone = UI_TXT_TONE_CALL;
-        else if (tone > PROT_26_TONE_CALL)
-            mCurrTone = UI_TXT_TONE_ALARM;
-    }
-
-    // display text
-    mDisplayText.clear();
-    mCurrDisplayText = QString::fromUtf8(frontText);
-    mDisplayText.append(mCurrDisplayText);
-    if (isBlinking)
-    {
-        mDisplayText.append(QString::fromUtf8(backText));
-
-        if (!mBlinkTimer->isActive())
-            mBlinkTimer->start();
-    }
-    else
-    {
-        if(mBlinkTimer->isActive())
-            mBlinkTimer->stop();
-    }
-
-    ui->ledDisplay->setText(mCurrDisplayText);
+    mDisplay.setProtocol(byte, mDisplayClock.elapsed());
 
-    ui->labelTone->setText(QApplication::translate("MainWindow",mCurrTone));
+    updateDisplay();
 }
 
-void MainWindow::onBlinkTimerTimeout()
+void MainWindow::onDisplayTimerTimeout()
 {
-    QString text = mCurrDisplayText;
-
-    if (mDisplayText.first().contains(text))
-        mCurrDisplayText = mDisplayText.last();
-    else
-        mCurrDisplayText = mDisplayText.first();
+    mDisplay.advanceTo(mDisplayClock.elapsed());
 
-    ui->ledDisplay->setText(mCurrDisplayText);
+    updateDisplay();
 }
 
-void MainWindow::onSlidingDelayTimerTimeout()
+// show the emulated display state and schedule its next timer event
+void MainWindow::updateDisplay()
 {
-    if (!mSlidingTimer->isActive())
-    {
-        mSlidingTimer->start();
-        mSlidingLength = mCurrDisplayText.length();
-
-        if (mSlidingAndBlinking)
-        {
-            if(mBlinkTimer->isActive())
-                mBlinkTimer->stop();
-
-            mCurrDisplayText = mDisplayText.first();
-            ui->ledDisplay->setText(mCurrDisplayText);
-        }
-    }
-}
+    if (mDisplay.isMultipleText())
+        ui->indicatorMultipleText->setText(":");
+    else
+        ui->indicatorMultipleText->clear();
 
-void MainWindow::onSlidingTimerTimeout()
-{
-    QString text;
+    mCurrTone = UI_TXT_TONE_NONE;
+    if (mDisplay.tone() == TONE_CALL)
+        mCurrTone = UI_TXT_TONE_CALL;
+    else if (mDisplay.tone() == TONE_ALARM)
+        mCurrTone = UI_TXT_TONE_ALARM;
 
-    if (mDisplayText.size())
-    {
-        --mSlidingLength;
+    ui->ledDisplay->setText(mDisplay.text());
 
-        if (mSlidingLength)
-        {
-            text = mCurrDisplayText.right(mSlidingLength);
-        }
-        else
-        {
-            text = mDisplayText.first();
-            mSlidingLength = text.length();
-            mSlidingTimer->stop();
-            mSlidingDelayTimer->start();
+    ui->labelTone->setText(QApplication::translate("MainWindow",mCurrTone));
 
-            if (mSlidingAndBlinking)
-            {
-                if (!mBlinkTimer->isActive())
-                    mBlinkTimer->start();
-            }
-        }
+    qint64 due = mDisplay.nextEvent();
 
-        mCurrDisplayText = text;
-        ui->ledDisplay->setText(mCurrDisplayText);
-    }
+    if (due >= 0)
+        mDisplayTimer->start(int(qMax(qint64(0), due - mDisplayClock.elapsed())));
+    else
+        mDisplayTimer->stop();
 }
 
 void MainWindow::onDummyProtocolSent()
@@ -627,27 +614,14 @@ void MainWindow::onDummyProtocolSent()
 
 void MainWindow::adjustSerialFrame()
 {
-    int frame = 0; // bits per byte
     if (mSerialProtocol && mSerialPort)
     {
-        if (mSerialPort->dataBits() > 0)
-            frame += mSerialPort->dataBits();
-        else
+        if ((mSerialPort->dataBits() <= 0) || (mSerialPort->stopBits() <= 0))
             return;
 
-        if (mSerialPort->parity() > 0)
-            ++frame;
-
-        if (mSerialPort->stopBits() > 0)
-        {
-            ++frame;
-            if (mSerialPort->stopBits() != QSerialPort::OneStop)
-                ++frame;
-        }
-        else
-            return;
-
-        mSerialProtocol->setSerialFrame(frame);
+        mSerialProtocol->setSerialFrame(SerialProtocol::bitsPerByte(mSerialPort->dataBits(),
+                                                                    mSerialPort->parity() > 0,
+                                                                    mSerialPort->stopBits() == QSerialPort::OneStop ? 1 : 2));
     }
 }
 
@@ -694,3 +668,8 @@ void MainWindow::showTxBytes(QByteArray bytes)
 {
     ui->protocolView->insertPlainText(UI_PROTOCOL_VIEW_TX + bytes.toHex() + "\n");
 }
+
+void MainWindow::showTxFrame(QByteArray frame)
+{
+    ui->protocolView->insertPlainText(UI_PROTOCOL_VIEW_TX + frame.mid(1, frame.length() - 2) + "\n");
+}
@@ -16,6 +16,11 @@
 #include "testmanager.h"
 #include <QDialog>
 #include "setupwizard.h"
+#include "displaymodel.h"
+#include "resultsstore.h"
+#include "runrecorder.h"
+#include "checkpointjournal.h"
+#include <QElapsedTimer>
 
 #include <QTranslator>
 #include <QLibraryInfo>
@@ -30,20 +35,24 @@ class MainWindow : public QMainWindow
     Q_OBJECT
 
 public:
-    explicit MainWindow(QJsonObject configOptions, QJsonObject testPatterns, QWidget *parent = 0);
+    explicit MainWindow(QJsonObject configOptions, QJsonObject testPatterns,
+                        const TestPatternGenerator &testRules, QWidget *parent = 0);
     ~MainWindow();
 
+    bool setFrameCorpus(const QString &fileName);
+
 private slots:
     void on_configButton_clicked();
     void on_startStopButton_clicked();
+    void on_testPassedButton_clicked();
+    void on_testFailedButton_clicked();
     void onTestStarted();
     void onTestStopped();
     void onSetupAccepted();
     void onProtocolSent(QByteArray byte);
-    void onBlinkTimerTimeout();
-    void onSlidingTimerTimeout();
-    void onSlidingDelayTimerTimeout();
+    void onDisplayTimerTimeout();
     void onDummyProtocolSent();
+    void onCheckpointTimeout();
     void adjustSerialFrame();
     void adjustSerialDataRate();
     void showRxAck();
@@ -52,17 +61,23 @@ private slots:
     void showRxEtx();
     void showRxEot();
     void showTxBytes(QByteArray bytes);
+    void showTxFrame(QByteArray frame);
     void showRxBytes(QString str);
 
 private:
     Ui::MainWindow *ui;
-    SetupWizard *mSetupWizard;
+    SetupWizard *mSetupWizard;      // created on first use
+    QJsonObject mConfigOptions;     // options of the setup wizard
     TestManager *mTestManager;
     QSerialPort *mSerialPort;
     SerialProtocol *mSerialProtocol;
 
     QJsonObject mCfgFlurdisplay;      // flurdisplay settings
     QJsonObject mCfgTest;    // test patterns
+    TestPatternGenerator mTestRules;    // compiled test patterns
+    FrameCorpus mFrameCorpus;           // precompiled frames of the test patterns
+
+    SetupWizard *setupWizard();
 
     QJsonObject makeDefaultDeviceConfig();
     QJsonObject makeDefaultTestPatterns();
@@ -72,16 +87,22 @@ private:
     bool openSerialPort();
     void closeSerialPort();
 
+    RunRecorder *mRunRecorder;  // metrics of the running test
+    ResultsStore mResults;      // history of the test runs
+    QString mLastSerial;        // serial number of the last tested display
+    CheckpointJournal mCheckpoint;  // state of the running test, resumed after a crash
+    QTimer *mCheckpointTimer;
+
+    void saveResult(const QString &verdict);
+    bool resumeTest();
+
     void updateConfigurationLabel(QJsonObject config);
-    QTimer *mBlinkTimer;
-    QStringList mDisplayText;
-    QString mCurrDisplayText;   // text on GUI display
+    void updateDisplay();
+    DisplayModel mDisplay;      // emulated display state
+    QTimer *mDisplayTimer;      // next blink or sliding event of the display
+    QElapsedTimer mDisplayClock;
     QByteArray mSentProtocol;
     const char* mCurrTone;          // tone indicator on GUI
-    QTimer *mSlidingTimer;
-    QTimer *mSlidingDelayTimer;
-    int mSlidingLength;
-    bool mSlidingAndBlinking;   // sliding with blinking, only for 0x28 command
 };
 
 #endif // MAINWINDOW_H
@@ -1,6 +1,27 @@
 #include <mainwindow.h>
 #include <QApplication>
 #include <QDir>
+#include <QCommandLineParser>
+#include <configloader.h>
+#include <testmanager.h>
+#include <goldencorpus.h>
+#include <goldentimeline.h>
+#include <testlink.h>
+#include <scriptengine.h>
+#include <soaktest.h>
+#include <protocolfuzzer.h>
+#include <busscheduler.h>
+#include <bustest.h>
+#include <bussniffer.h>
+#include <firmwareprofiler.h>
+#include <baudsweep.h>
+#include <portprober.h>
+#include <resultsstore.h>
+#include <portpool.h>
+#include <QSerialPortInfo>
+#include <QEventLoop>
+#include <QDateTime>
+#include <QElapsedTimer>
 
 /**
  * The application is used to test the functionality of Flurdisplay
@@ -30,10 +51,371 @@
  */
 using namespace fd;
 
+// run test cycle on a simulated device in virtual time, return true on errors
+static bool simulate(const QJsonObject &config, const QJsonObject &test, const TestPatternGenerator &rules,
+                     double hours, const QString &faultSpec, quint64 seed)
+{
+    TestLink link;
+    QElapsedTimer elapsed;
+
+    elapsed.start();
+
+    if (link.open(config, true, faultSpec, seed))
+        return true;
+
+    TestManager testManager(link.serialProtocol(), config, test, &rules);
+
+    testManager.setClock(link.clock());
+
+    if (!testManager.start())
+        return true;
+
+    link.virtualClock()->runFor(qint64(hours * 3600 * 1000));
+    testManager.stop();
+    link.virtualClock()->runFor(PERIOD_TEXT);
+    link.printFaults();
+
+    qDebug() << "simulated" << link.clock()->now() / 1000 << "s:" << link.simulatedDevice()->framesReceived()
+             << "frames in" << elapsed.elapsed() << "ms";
+
+    if (testManager.isChangeOnly())
+        qDebug() << "change-only:" << testManager.framesSuppressed() << "frames of unchanged content suppressed";
+    return false;
+}
+
+// run test script on the host interface or on a simulated device in virtual time, return true on errors
+static bool runScript(const QJsonObject &config, const QJsonObject &test, const TestPatternGenerator &rules,
+                      const QString &fileName, bool isVirtual, const QString &faultSpec, quint64 seed)
+{
+    QJsonObject script;
+    TestLink link;
+
+    if (ConfigLoader::load(fileName, script) || link.open(config, isVirtual, faultSpec, seed))
+        return true;
+
+    TestManager testManager(link.serialProtocol(), config, test, &rules);
+    ScriptEngine engine(&testManager, link.serialProtocol());
+
+    if (engine.load(script))
+        return true;
+
+    testManager.setClock(link.clock());
+    engine.setClock(link.clock());
+
+    link.watch(&engine, SIGNAL(finished(bool)));
+    engine.start();
+    link.exec();
+
+    return !engine.hasPassed();
+}
+
+// send randomized frames at line rate for given hours, return true on errors
+static bool runSoak(const QJsonObject &config, const QJsonObject &test, const TestPatternGenerator &rules,
+                    double hours, quint64 seed, const QString &logFileName, bool isVirtual, const QString &faultSpec)
+{
+    TestLink link;
+
+    if (link.open(config, isVirtual, faultSpec, seed))
+        return true;
+
+    TestManager testManager(link.serialProtocol(), config, test, &rules);
+    SoakTest soak(&testManager, link.serialProtocol(), seed);
+
+    if (!logFileName.isEmpty() && soak.setLogFile(logFileName))
+        return true;
+
+    qDebug() << "soak test seed:" << seed;
+
+    soak.setClock(link.clock());
+
+    link.watch(&soak, SIGNAL(finished()));
+    soak.start(qint64(hours * 3600 * 1000));
+    link.exec();
+
+    return soak.framesSent() == 0;
+}
+
+// send mutated frames for given hours, return true on findings
+static bool runFuzzer(const QJsonObject &config, const QJsonObject &test, const TestPatternGenerator &rules,
+                      double hours, quint64 seed, const QString &logFileName, bool isVirtual, const QString &faultSpec)
+{
+    TestLink link;
+
+    if (link.open(config, isVirtual, faultSpec, seed))
+        return true;
+
+    TestManager testManager(link.serialProtocol(), config, test, &rules);
+    ProtocolFuzzer fuzzer(&testManager, link.serialProtocol(), seed);
+
+    if (!logFileName.isEmpty() && fuzzer.setLogFile(logFileName))
+        return true;
+
+    qDebug() << "fuzzer seed:" << seed;
+
+    link.simulatedDevice()->setValidate(true);
+    fuzzer.setClock(link.clock());
+
+    link.watch(&fuzzer, SIGNAL(finished()));
+    fuzzer.start(qint64(hours * 3600 * 1000));
+    link.exec();
+
+    return fuzzer.findings() != 0;
+}
+
+// LR-addresses of the address list <spec>, e.g. "1.1-1.30", return true on errors
+static bool parseAddresses(const QString &spec, QVector<quint16> &addresses)
+{
+    QVector<sAddrRange> addrList;
+
+    addresses.clear();
+
+    if (TestPatternGenerator::parseAddrList(QJsonObject{{RulesMatchAddrListStations, spec}}, addrList))
+        return true;
+
+    for (quint64 i = 0; TestPatternGenerator::addrAt(addrList, i); ++i)
+        addresses << TestPatternGenerator::addrAt(addrList, i);
+
+    return addresses.isEmpty();
+}
+
+// address the displays of a RS485 segment for given hours, return true on errors
+static bool runBus(const QJsonObject &config, const QJsonObject &test, const TestPatternGenerator &rules,
+                   double hours, const QString &displaySpec, const QString &groupSpec, const QString &policy,
+                   bool isVirtual, const QString &faultSpec, quint64 seed)
+{
+    QVector<quint16> displays;
+    TestLink link;
+
+    if (parseAddresses(displaySpec, displays) || link.open(config, isVirtual, faultSpec, seed))
+        return true;
+
+    TestManager testManager(link.serialProtocol(), config, test, &rules);
+    BusScheduler scheduler(link.serialProtocol());
+    BusTest bus(&testManager, &scheduler);
+
+    link.simulatedDevice()->setAddresses(displays.toList().toSet());
+    scheduler.setDisplays(displays);
+
+    // groups: <group>=<members>;..., e.g. "1.1=1.1-1.15;1.2=1.16-1.30"
+    foreach (const QString &item, groupSpec.split(';', QString::SkipEmptyParts))
+    {
+        QVector<quint16> group;
+        QVector<quint16> members;
+
+        if ((item.count('=') != 1) || parseAddresses(item.section('=', 0, 0), group) ||
+                parseAddresses(item.section('=', 1), members) || scheduler.addGroup(group.first(), members))
+        {
+            qWarning() << "invalid group" << item;
+            return true;
+        }
+    }
+
+    scheduler.setPolicy(BusScheduler::policyFromString(policy));
+    bus.setClock(link.clock());
+
+    link.watch(&bus, SIGNAL(finished()));
+    bus.start(qint64(hours * 3600 * 1000));
+    link.exec();
+
+    foreach (quint16 addr, displays)
+    {
+        if (!scheduler.isOnline(addr))
+            return true;
+    }
+
+    return bus.framesQueued() == 0;
+}
+
+// profile the response times of the firmware and save them to a file, return true on errors
+static bool runProfile(const QJsonObject &config, const QJsonObject &test, const TestPatternGenerator &rules,
+                       const QString &fileName, int repeat, bool isVirtual, const QString &faultSpec, quint64 seed)
+{
+    TestLink link;
+
+    if (link.open(config, isVirtual, faultSpec, seed))
+        return true;
+
+    TestManager testManager(link.serialProtocol(), config, test, &rules);
+    FirmwareProfiler profiler(&testManager, link.serialProtocol(), config);
+
+    profiler.setClock(link.clock());
+    profiler.setRepeat(repeat);
+
+    link.watch(&profiler, SIGNAL(finished()));
+    profiler.start();
+    link.exec();
+
+    return profiler.save(fileName);
+}
+
+// sweep the serial settings for given seconds each, return true if no setting is reliable
+static bool runSweep(const QJsonObject &config, const QJsonObject &test, const TestPatternGenerator &rules,
+                     double seconds, const QString &rates, bool isVirtual, const QString &faultSpec, quint64 seed)
+{
+    QJsonObject hostInterface = config[isVirtual ? DevInterfaceSection : HostInterfaceSection].toObject();
+    TestLink link;
+
+    if (link.open(config, isVirtual, faultSpec, seed))
+        return true;
+
+    TestManager testManager(link.serialProtocol(), config, test, &rules);
+    BaudSweep sweep(&testManager, link.serialProtocol(), hostInterface[ConfigParam].toString().split(","));
+
+    if (!rates.isEmpty())
+    {
+        QList<int> list;
+
+        foreach (const QString &rate, rates.split(',', QString::SkipEmptyParts))
+            list << rate.toInt();
+
+        sweep.setRates(list);
+    }
+
+    if (isVirtual)
+        sweep.setSimulatedDevice(link.simulatedDevice());
+    else
+        sweep.setSerialPort(link.serialPort());
+
+    sweep.setClock(link.clock());
+    sweep.setDuration(int(seconds * 1000));
+
+    link.watch(&sweep, SIGNAL(finished()));
+    sweep.start();
+    link.exec();
+
+    return sweep.best() < 0;
+}
+
+// probe all serial ports for displays, return true if none is found
+static bool runProbe(const QJsonObject &configOptions)
+{
+    PortProber prober;
+    QEventLoop loop;
+    QStringList ports;
+
+    foreach (const QSerialPortInfo &info, QSerialPortInfo::availablePorts())
+        ports << info.portName();
+
+    prober.setInterfaces(configOptions[DevInterfaceSection].toArray());
+    QObject::connect(&prober, SIGNAL(finished()), &loop, SLOT(quit()));
+
+    prober.start(ports);
+
+    if (prober.isRunning())
+        loop.exec();
+
+    foreach (const PortProber::sResult &result, prober.results())
+        qDebug().noquote() << QString("%1: %2 %3").arg(result.port, result.interfaceName, result.param);
+
+    return prober.results().isEmpty();
+}
+
+// run the test cycle on each plugged adapter with one of the serial numbers ("*": any), until terminated
+static bool runPool(const QJsonObject &config, const QJsonObject &test, const TestPatternGenerator &rules,
+                    const QString &serialNumbers)
+{
+    PortPool pool(config, test, &rules);
+    QEventLoop loop;
+
+    if (config[HostInterfaceSection].toObject()[ConfigParam].toString().split(",").count() != 4)
+    {
+        qWarning() << "invalid host interface param" << config[HostInterfaceSection].toObject()[ConfigParam].toString();
+        return true;
+    }
+
+    pool.setSerialNumbers(serialNumbers.split(',', QString::SkipEmptyParts));
+    pool.start();
+    loop.exec();
+
+    return false;
+}
+
+// list the test runs matching the query, return true on errors
+static bool runQuery(const QString &spec)
+{
+    ResultsStore store;
+    ResultsStore::sQuery query;
+
+    if (ResultsStore::parseQuery(spec, query) || store.open(ResultsStore::defaultDir()))
+        return true;
+
+    QVector<quint64> runs = store.find(query);
+
+    foreach (quint64 idx, runs)
+    {
+        sRunResult run;
+
+        if (store.read(idx, run))
+        {
+            qWarning() << "cannot read test run" << idx;
+            return true;
+        }
+
+        qDebug().noquote() << QString("%1 %2 %3 %4 %5 %6 %7: %8 s, sent %9, ack %10, nack %11")
+                              .arg(run.start.toString(Qt::ISODate), run.serial, run.device, run.firmware,
+                                   run.devInterface, run.port, run.verdict)
+                              .arg(run.duration / 1000.0, 0, 'f', 1).arg(run.sent).arg(run.ack).arg(run.nack);
+    }
+
+    qDebug().noquote() << QString("%1 of %2 test runs").arg(runs.count()).arg(store.count());
+    return false;
+}
+
+// capture and decode the traffic of the host interface line for given hours, return true on errors
+static bool runSniffer(const QJsonObject &config, double hours, const QString &fileName)
+{
+    TestLink link;
+    BusSniffer sniffer;
+
+    if (link.openPassive(config) || (!fileName.isEmpty() && sniffer.setCaptureFile(fileName)))
+        return true;
+
+    sniffer.setDevice(link.serialPort());
+    sniffer.setByteTime(link.byteTime());
+    sniffer.setLive(true);
+
+    link.watch(&sniffer, SIGNAL(finished()));
+    sniffer.start(qint64(hours * 3600 * 1000));
+    link.exec();
+
+    return false;
+}
+
 int main(int argc, char *argv[])
 {
+    QElapsedTimer startup;
+    startup.start();
+
     QApplication a(argc, argv);
 
+    // load configurations (device setup and test patterns) in background, overlapped with the startup
+    QString configPath = QString(getenv("USERPROFILE"));
+    QStringList configFileList;
+    QJsonObject configs[2];
+    TestPatternGenerator testRules;   // compiled test patterns
+    QList<QFuture<bool> > loading;
+
+    configFileList << configOptionsFileName << testPatternsFileName;
+
+    for (int i = 0; i < configFileList.count(); ++i)
+    {
+        QString fileName = QDir::toNativeSeparators(configPath + configFileList.at(i));
+
+        if (!QFile::exists(fileName))
+        {
+            QFile defaultFile(":/conf" + configFileList.at(i));
+
+            if (!defaultFile.copy(fileName))
+            {
+                qWarning() << "cannot copy" << defaultFile.fileName() << "to" << fileName;
+                exit(1);
+            }
+        }
+
+        loading << ConfigLoader::loadAsync(fileName, &configs[i],
+                                           (configFileList.at(i) == testPatternsFileName) ? &testRules : 0);
+    }
+
     QTranslator qtTranslator;
     qtTranslator.load("qt_" + QLocale::system().name(),
                       QLibraryInfo::location(QLibraryInfo::TranslationsPath));
@@ -43,71 +425,243 @@ int main(int argc, char *argv[])
     appTranslator.load("fdTest_" + QLocale::system().name());
     a.installTranslator(&appTranslator);
 
-    // load configurations (device setup and test patterns)
-    QString configPath = QString(getenv("USERPROFILE"));
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Flurdisplay test");
+    parser.addHelpOption();
+
+    QCommandLineOption writeCorpusOption("write-corpus",
+                                         "Write frames of all test patterns to <file> and exit.", "file");
+    QCommandLineOption corpusOption("corpus",
+                                    "Send precompiled frames from <file> instead of encoding the test patterns.", "file");
+    QCommandLineOption writeGoldenOption("write-golden",
+                                         "Write golden frames of all device types to <dir> and exit.", "dir");
+    QCommandLineOption checkGoldenOption("check-golden",
+                                         "Compare frames of all device types with golden frames in <dir> and exit.", "dir");
+    QCommandLineOption writeTimelineOption("write-timeline",
+                                           "Write golden display timelines of all device types to <dir> and exit.", "dir");
+    QCommandLineOption checkTimelineOption("check-timeline",
+                                           "Compare display timelines of all device types with golden timelines in <dir> and exit.", "dir");
+    QCommandLineOption simulateOption("simulate",
+                                      "Run the test cycle for <hours> on a simulated device in virtual time and exit.", "hours");
+    QCommandLineOption scriptOption("script",
+                                    "Run the test script <file> and exit.", "file");
+    QCommandLineOption virtualOption("virtual",
+                                     "Run the test script, soak test, fuzzer or bus test on a simulated device in virtual time.");
+    QCommandLineOption soakOption("soak",
+                                  "Send randomized frames at line rate for <hours> and exit.", "hours");
+    QCommandLineOption seedOption("seed",
+                                  "Seed of the randomized frames of the soak test and the fuzzer.", "seed");
+    QCommandLineOption soakLogOption("soak-log",
+                                     "Write statistics of the soak test per minute to <file> (CSV).", "file");
+    QCommandLineOption fuzzOption("fuzz",
+                                  "Send mutated frames for <hours> and exit.", "hours");
+    QCommandLineOption fuzzLogOption("fuzz-log",
+                                     "Write findings of the fuzzer to <file> (CSV).", "file");
+    QCommandLineOption faultsOption("faults",
+                                    "Impair the link of the command line test modes by faults <spec> (seeded by --seed), "
+                                    "e.g. drop=0.001,flip=0.0005,dup=0.0001,latency=5,jitter=3,silence=0.0001,silenceMs=200.", "spec");
+    QCommandLineOption busOption("bus",
+                                 "Address the displays of a RS485 segment individually for <hours> and exit.", "hours");
+    QCommandLineOption displaysOption("displays",
+                                      "LR-addresses of the displays of the bus test, e.g. \"1.1-1.30\".", "addresses", "1.1");
+    QCommandLineOption busGroupsOption("bus-groups",
+                                       "Groups of the displays of the bus test, sent one frame if their content is equal, "
+                                       "e.g. \"1.1=1.1-1.15;1.2=1.16-1.30\".", "groups");
+    QCommandLineOption busPolicyOption("bus-policy",
+                                       "Order of the frames of the bus test: rr (round robin) or priority.", "policy", "rr");
+    QCommandLineOption sniffOption("sniff",
+                                   "Capture and decode the traffic of all participants on the host interface line "
+                                   "for <hours> (0: until terminated) and exit.", "hours");
+    QCommandLineOption sniffLogOption("sniff-log",
+                                      "Write the events captured by the sniffer to <file>.", "file");
+    QCommandLineOption profileOption("profile",
+                                     "Measure the response times of the firmware per command and payload length, "
+                                     "save them to <file> and exit.", "file");
+    QCommandLineOption profileRepeatOption("profile-repeat",
+                                           "Number of frames per command and payload length of the profile.", "count", "100");
+    QCommandLineOption profileCompareOption("profile-compare",
+                                            "Compare the profiles <base>,<file> (e.g. of two firmware versions) and exit.",
+                                            "files");
+    QCommandLineOption sweepOption("sweep",
+                                   "Test each baud rate and number of stop bits for <seconds>, report the fastest "
+                                   "reliable setting and exit.", "seconds");
+    QCommandLineOption sweepRatesOption("sweep-rates",
+                                        "Baud rates of the sweep.", "rates", "9600,19200,38400,57600,115200");
+    QCommandLineOption probeOption("probe",
+                                   "Probe all serial ports with the device interfaces, list the ports with a display and exit.");
+    QCommandLineOption poolOption("pool",
+                                  "Run the test cycle on each plugged serial adapter with one of the <serials> "
+                                  "(comma separated, * for any), attached and detached on hot-plug.", "serials");
+    QCommandLineOption queryResultsOption("query-results",
+                                          "List the saved test runs matching <query> "
+                                          "(serial=<serial>,firmware=<firmware>,from=<date>,to=<date>) and exit.",
+                                          "query");
+    parser.addOption(writeCorpusOption);
+    parser.addOption(corpusOption);
+    parser.addOption(writeGoldenOption);
+    parser.addOption(checkGoldenOption);
+    parser.addOption(writeTimelineOption);
+    parser.addOption(checkTimelineOption);
+    parser.addOption(simulateOption);
+    parser.addOption(scriptOption);
+    parser.addOption(virtualOption);
+    parser.addOption(soakOption);
+    parser.addOption(seedOption);
+    parser.addOption(soakLogOption);
+    parser.addOption(fuzzOption);
+    parser.addOption(fuzzLogOption);
+    parser.addOption(faultsOption);
+    parser.addOption(busOption);
+    parser.addOption(displaysOption);
+    parser.addOption(busGroupsOption);
+    parser.addOption(busPolicyOption);
+    parser.addOption(sniffOption);
+    parser.addOption(sniffLogOption);
+    parser.addOption(profileOption);
+    parser.addOption(profileRepeatOption);
+    parser.addOption(profileCompareOption);
+    parser.addOption(sweepOption);
+    parser.addOption(sweepRatesOption);
+    parser.addOption(probeOption);
+    parser.addOption(queryResultsOption);
+    parser.addOption(poolOption);
+    parser.process(a);
+
     QJsonObject configOptions;
     QJsonObject testPatterns;
-    QStringList configFileList;
-    QFile configFile;
 
-    configFileList << configOptionsFileName << testPatternsFileName;
+    for (int i = 0; i < configFileList.count(); ++i)
+    {
+        if (loading[i].result())
+            exit(3);
+
+        if (configs[i].isEmpty())
+        {
+            qWarning() << "configuration is not defined in:" << QDir::toNativeSeparators(configPath + configFileList.at(i));
+            exit(4);
+        }
+    }
+
+    configOptions = configs[0]; // configuration for a DUT
+    testPatterns = configs[1];  // test patterns for a DUT
 
-    foreach (QString name, configFileList)
+    qDebug() << "configuration loaded after" << startup.elapsed() << "ms";
+
+    if (parser.isSet(writeCorpusOption) || parser.isSet(simulateOption) || parser.isSet(scriptOption) ||
+            parser.isSet(soakOption) || parser.isSet(fuzzOption) || parser.isSet(busOption) ||
+            parser.isSet(sniffOption) || parser.isSet(profileOption) || parser.isSet(sweepOption) ||
+            parser.isSet(poolOption))
     {
-        configFile.setFileName(QDir::toNativeSeparators(configPath + name));
+        // test setup of the application, i.e., device configuration and test patterns
+        QJsonObject config;
+        QJsonObject cfgTest = testPatterns[RulesSection].toObject();
+        QJsonObject cfgFlurdisplay;
 
-        if(!configFile.exists())
+        if (QFile::exists(configFileName))
         {
-            QFile defaultFile(":/conf" + name);
+            if (ConfigLoader::load(configFileName, config, &testRules))
+                exit(3);
 
-            if (!defaultFile.copy(configFile.fileName()))
-            {
-                qWarning() << "cannot copy" << defaultFile.fileName() << "to" << configFile.fileName();
-                exit(1);
-            }
+            cfgTest = config[RulesSection].toObject();
+            cfgFlurdisplay = config[FlurdisplaySection].toObject();
         }
-
-        if (!configFile.open(QIODevice::ReadOnly))
+        else if (!GoldenCorpus::variants(configOptions).isEmpty())
         {
-            qWarning() << "cannot open" << configFile.fileName();
-            exit(2);
+            cfgFlurdisplay = GoldenCorpus::variants(configOptions).first().config;  // 1st device type and interface
         }
 
-        QByteArray data = configFile.readAll();
-        configFile.close();
+        quint64 seed = parser.isSet(seedOption) ? parser.value(seedOption).toULongLong()
+                                                : QDateTime::currentMSecsSinceEpoch();
 
-        QJsonParseError parser;
-        QJsonDocument setupDoc = QJsonDocument::fromJson(data, &parser);
+        if (parser.isSet(poolOption))
+            return runPool(cfgFlurdisplay, cfgTest, testRules, parser.value(poolOption)) ? 5 : 0;
 
-        if (parser.error)
-        {
-            qWarning() << "json parse error in" << parser.errorString();
-            exit(3);
-        }
+        if (parser.isSet(sweepOption))
+            return runSweep(cfgFlurdisplay, cfgTest, testRules, parser.value(sweepOption).toDouble(),
+                            parser.value(sweepRatesOption), parser.isSet(virtualOption), parser.value(faultsOption),
+                            seed) ? 6 : 0;
+
+        if (parser.isSet(profileOption))
+            return runProfile(cfgFlurdisplay, cfgTest, testRules, parser.value(profileOption),
+                              parser.value(profileRepeatOption).toInt(), parser.isSet(virtualOption),
+                              parser.value(faultsOption), seed) ? 5 : 0;
+
+        if (parser.isSet(sniffOption))
+            return runSniffer(cfgFlurdisplay, parser.value(sniffOption).toDouble(), parser.value(sniffLogOption)) ? 5 : 0;
+
+        if (parser.isSet(busOption))
+            return runBus(cfgFlurdisplay, cfgTest, testRules, parser.value(busOption).toDouble(),
+                          parser.value(displaysOption), parser.value(busGroupsOption), parser.value(busPolicyOption),
+                          parser.isSet(virtualOption), parser.value(faultsOption), seed) ? 6 : 0;
+
+        if (parser.isSet(fuzzOption))
+            return runFuzzer(cfgFlurdisplay, cfgTest, testRules, parser.value(fuzzOption).toDouble(), seed,
+                             parser.value(fuzzLogOption), parser.isSet(virtualOption), parser.value(faultsOption)) ? 7 : 0;
+
+        if (parser.isSet(soakOption))
+            return runSoak(cfgFlurdisplay, cfgTest, testRules, parser.value(soakOption).toDouble(), seed,
+                           parser.value(soakLogOption), parser.isSet(virtualOption), parser.value(faultsOption)) ? 6 : 0;
+
+        if (parser.isSet(scriptOption))
+            return runScript(cfgFlurdisplay, cfgTest, testRules, parser.value(scriptOption), parser.isSet(virtualOption),
+                             parser.value(faultsOption), seed) ? 6 : 0;
+
+        if (parser.isSet(simulateOption))
+            return simulate(cfgFlurdisplay, cfgTest, testRules, parser.value(simulateOption).toDouble(),
+                            parser.value(faultsOption), seed) ? 5 : 0;
 
-        if (setupDoc.isObject())
+        SerialProtocol serialProtocol;
+        TestManager testManager(&serialProtocol, cfgFlurdisplay, cfgTest, &testRules);
+
+        return testManager.writeCorpus(parser.value(writeCorpusOption)) ? 5 : 0;
+    }
+
+    if (parser.isSet(probeOption))
+        return runProbe(configOptions) ? 6 : 0;
+
+    if (parser.isSet(queryResultsOption))
+        return runQuery(parser.value(queryResultsOption)) ? 5 : 0;
+
+    if (parser.isSet(profileCompareOption))
+    {
+        QStringList files = parser.value(profileCompareOption).split(',');
+
+        if (files.count() != 2)
         {
-            if (setupDoc.object().isEmpty())
-            {
-                qWarning() << "configuration is not defined in:" << configFile.fileName();
-                exit(4);
-            }
-            else
-            {
-                if (name == configOptionsFileName)
-                {
-                    configOptions = setupDoc.object(); // configuration for a DUT
-                }
-                else if (name == testPatternsFileName)
-                {
-                    testPatterns = setupDoc.object(); // test patterns for a DUT
-                }
-            }
+            qWarning() << "two profiles required:" << files;
+            return 5;
         }
+
+        return FirmwareProfiler::compare(files.at(0), files.at(1)) ? 5 : 0;
     }
 
-    MainWindow mainWindow(configOptions, testPatterns);
+    if (parser.isSet(writeGoldenOption) || parser.isSet(checkGoldenOption))
+    {
+        GoldenCorpus golden(configOptions, testPatterns[RulesSection].toObject(), testRules);
+
+        if (parser.isSet(writeGoldenOption))
+            return golden.write(parser.value(writeGoldenOption)) ? 5 : 0;
+
+        return golden.check(parser.value(checkGoldenOption)) ? 6 : 0;
+    }
+
+    if (parser.isSet(writeTimelineOption) || parser.isSet(checkTimelineOption))
+    {
+        GoldenTimeline golden(configOptions, testPatterns[RulesSection].toObject(), testRules);
+
+        if (parser.isSet(writeTimelineOption))
+            return golden.write(parser.value(writeTimelineOption)) ? 5 : 0;
+
+        return golden.check(parser.value(checkTimelineOption)) ? 6 : 0;
+    }
+
+    MainWindow mainWindow(configOptions, testPatterns, testRules);
+
+    if (parser.isSet(corpusOption))
+        mainWindow.setFrameCorpus(parser.value(corpusOption));
+
     mainWindow.show();
+    qDebug() << "startup time:" << startup.elapsed() << "ms";
 
     return a.exec();
 }
@@ -0,0 +1,333 @@
+#include "bussniffer.h"
+#include "serialprotocol.h"
+#include "frameencoder.h"
+#include <QDebug>
+#include <QTextStream>
+#include <ctype.h>
+#include <fd.h>
+
+using namespace fd;
+
+BusSniffer::BusSniffer(QObject *parent) :
+    QObject(parent)
+{
+    mDevice = 0;
+    mIsLive = false;
+    mIsRunning = false;
+    mByteTime = 0;
+    mLastTime = 0;
+    mFrameTime = 0;
+    mCntGarbage = 0;
+
+    mEndTimer.setSingleShot(true);
+    mReportTimer.setInterval(10000);
+
+    connect(&mEndTimer, SIGNAL(timeout()), this, SLOT(stop()));
+    connect(&mReportTimer, SIGNAL(timeout()), this, SLOT(onReportTimeout()));
+}
+
+void BusSniffer::setDevice(QIODevice *device)
+{
+    if (mDevice)
+        disconnect(mDevice, 0, this, 0);
+
+    mDevice = device;
+
+    if (mDevice)
+        connect(mDevice, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+}
+
+// return true on errors
+bool BusSniffer::setCaptureFile(const QString &fileName)
+{
+    mCapture.setFileName(fileName);
+
+    if (!mCapture.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        qWarning() << "cannot create capture file" << fileName;
+        return true;
+    }
+
+    mCapture.write("time_us\tkind\traw\tdecoded\n");
+    return false;
+}
+
+void BusSniffer::start(qint64 duration)
+{
+    mIsRunning = true;
+    mLastTime = 0;
+    mFrame.clear();
+    mLastDestination.clear();
+    mCntGarbage = 0;
+    mStats.clear();
+
+    mClock.start();
+
+    if (duration > 0)
+        mEndTimer.start(duration);
+
+    mReportTimer.start();
+}
+
+void BusSniffer::stop()
+{
+    if (!mIsRunning)
+        return;
+
+    mIsRunning = false;
+    mEndTimer.stop();
+    mReportTimer.stop();
+    mCapture.flush();
+
+    report();
+    emit finished();
+}
+
+void BusSniffer::onReadyRead()
+{
+    qint64 readTime = mClock.nsecsElapsed();
+    QByteArray data = mDevice->readAll();
+
+    if (!mIsRunning || data.isEmpty())
+        return;
+
+    // the last byte arrived at read time, the others one byte time each before
+    qint64 time = qMax(mLastTime, readTime - (data.length() - 1) * mByteTime);
+
+    for (int i = 0; i < data.length(); ++i, time += mByteTime)
+    {
+        char ch = data.at(i);
+        qint64 byteTime = qMin(time, readTime);
+
+        if (ch == SerialProtocol::STX)
+        {
+            if (!mFrame.isEmpty())
+                mCntGarbage += mFrame.length();    // frame not terminated
+
+            mFrame = QByteArray(1, ch);
+            mFrameTime = byteTime;
+        }
+        else if (!mFrame.isEmpty())
+        {
+            mFrame.append(ch);
+
+            if (ch == SerialProtocol::ETX)
+            {
+                onFrame(mFrameTime, mFrame);
+                mFrame.clear();
+            }
+            else if (mFrame.length() >= MAX_FRAME)
+            {
+                mCntGarbage += mFrame.length();
+                mFrame.clear();
+            }
+        }
+        else if ((ch == SerialProtocol::ACK) || (ch == SerialProtocol::NACK) || (ch == SerialProtocol::EOT))
+        {
+            onResponse(byteTime, ch);
+        }
+        else
+        {
+            ++mCntGarbage;
+        }
+    }
+
+    mLastTime = qMin(time - mByteTime, readTime);
+}
+
+void BusSniffer::onReportTimeout()
+{
+    mCapture.flush();
+    report();
+}
+
+void BusSniffer::onFrame(qint64 time, const QByteArray &frame)
+{
+    sDecoded decoded = decode(frame);
+    sStats &s = stats(decoded.source, time);
+    QString description;
+
+    ++s.frames;
+    s.bytes += frame.length();
+
+    if (!decoded.error.isEmpty())
+    {
+        ++s.invalid;
+        description = "invalid: " + decoded.error;
+    }
+    else
+    {
+        description = QString("cmd %1 %2 -> %3 \"%4\"").arg(decoded.cmd, 2, 16, QChar('0'))
+                      .arg(decoded.source, decoded.destination, decoded.text);
+    }
+
+    mLastDestination = decoded.destination;
+
+    write(time, "frame", frame, description);
+    emit frameDecoded(time, frame);
+}
+
+void BusSniffer::onResponse(qint64 time, char response)
+{
+    sStats &s = stats(mLastDestination.isEmpty() ? QString("?") : mLastDestination, time);
+    const char *kind = "eot";
+
+    ++s.bytes;
+
+    if (response == SerialProtocol::ACK)
+    {
+        ++s.ack;
+        kind = "ack";
+    }
+    else if (response == SerialProtocol::NACK)
+    {
+        ++s.nack;
+        kind = "nack";
+    }
+
+    write(time, kind, QByteArray(1, response), mLastDestination);
+}
+
+void BusSniffer::write(qint64 time, const char *kind, const QByteArray &raw, const QString &decoded)
+{
+    QString line = QString("%1\t%2\t%3\t%4\n").arg(time / 1000).arg(kind)
+                   .arg(QString::fromLatin1(FrameEncoder::toHex(raw, true)), decoded);
+
+    if (mCapture.isOpen())
+        mCapture.write(line.toUtf8());
+
+    if (mIsLive)
+    {
+        QTextStream out(stdout);
+        out << line;
+    }
+}
+
+BusSniffer::sStats &BusSniffer::stats(const QString &source, qint64 time)
+{
+    sStats &s = mStats[source];
+
+    s.lastSeen = time / 1000;
+    return s;
+}
+
+void BusSniffer::report() const
+{
+    qDebug() << "sniffer:" << mClock.elapsed() / 1000 << "s," << mCntGarbage << "bytes outside of frames";
+
+    for (QMap<QString, sStats>::ConstIterator itr = mStats.constBegin(); itr != mStats.constEnd(); ++itr)
+    {
+        const sStats &s = itr.value();
+
+        qDebug().noquote() << QString("%1: %2 frames, %3 invalid, %4 ack, %5 nack, %6 bytes, last %7 ms")
+                              .arg(itr.key()).arg(s.frames).arg(s.invalid).arg(s.ack).arg(s.nack)
+                              .arg(s.bytes).arg(s.lastSeen / 1000);
+    }
+}
+
+// remove the blink bits of the characters
+QByteArray BusSniffer::unblink(const QByteArray &text)
+{
+    QByteArray plain = text;
+
+    for (int i = 0; i < plain.length(); ++i)
+        plain[i] = plain.at(i) & ~BLINK_CHAR;
+
+    return plain;
+}
+
+// frame: STX, optional special char, hex coded protocol, ETX
+BusSniffer::sDecoded BusSniffer::decode(const QByteArray &frame)
+{
+    sDecoded decoded;
+    int begin = 1;
+    int end = frame.length() - 1;
+
+    decoded.cmd = 0;
+    decoded.sender = 0;
+
+    if ((begin < end) && !isxdigit((uchar)frame.at(begin)))  // special char
+        ++begin;
+
+    for (int i = begin; i < end; ++i)
+    {
+        if (!isxdigit((uchar)frame.at(i)))
+        {
+            decoded.error = "non hex data";
+            return decoded;
+        }
+    }
+
+    if ((end - begin) % 2)
+    {
+        decoded.error = "odd number of hex digits";
+        return decoded;
+    }
+
+    QByteArray protocol = QByteArray::fromHex(frame.mid(begin, end - begin));
+
+    if (protocol.length() <= PROT_HDR_CMD)
+    {
+        decoded.error = "no header";
+        return decoded;
+    }
+
+    decoded.sender = protocol.at(PROT_HDR_SEND_ASW);
+    decoded.cmd = protocol.at(PROT_HDR_CMD);
+    decoded.source = QString("asw %1").arg(decoded.sender, 2, 16, QChar('0'));
+
+    if (decoded.cmd == LR_CMD_28)
+    {
+        if (protocol.length() <= PROT_28_PL_LENGTH)
+        {
+            decoded.error = "short header";
+            return decoded;
+        }
+
+        int length = (uchar)protocol.at(PROT_28_PL_LENGTH);
+
+        decoded.source = QString("%1.%2").arg((uchar)protocol.at(PROT_28_SRC_ST)).arg((uchar)protocol.at(PROT_28_SRC_RM));
+
+        if (protocol.at(PROT_28_DST_ST) || protocol.at(PROT_28_DST_RM) ||
+                (!protocol.at(PROT_28_ST_GRP) && !protocol.at(PROT_28_RM_GRP)))
+        {
+            decoded.destination = QString("%1.%2").arg((uchar)protocol.at(PROT_28_DST_ST))
+                                  .arg((uchar)protocol.at(PROT_28_DST_RM));
+        }
+        else
+        {
+            decoded.destination = QString("group %1.%2").arg((uchar)protocol.at(PROT_28_ST_GRP))
+                                  .arg((uchar)protocol.at(PROT_28_RM_GRP));
+        }
+
+        if (protocol.length() != PROT_28_PL_DATA + length + 1)     // payload, crc
+        {
+            decoded.error = "payload length";
+            return decoded;
+        }
+
+        decoded.text = QString::fromUtf8(unblink(protocol.mid(PROT_28_PL_DATA, length)));
+
+        if (FrameEncoder::checksum(protocol.constData() + PROT_28_PL_DATA, length) != (uchar)protocol.at(protocol.length() - 1))
+            decoded.error = "checksum";
+    }
+    else if ((decoded.cmd == LR_CMD_26) || (decoded.cmd == LR_CMD_27))
+    {
+        int payload = (decoded.cmd == LR_CMD_26) ? PROT_26_PL_DATA : PROT_27_ALARM_TYPE;
+
+        if (protocol.length() <= PROT_26_GRP)
+        {
+            decoded.error = "short header";
+            return decoded;
+        }
+
+        decoded.destination = QString("group %1").arg((uchar)protocol.at(PROT_26_GRP));
+        decoded.text = QString::fromUtf8(unblink(protocol.mid(payload)));
+    }
+    else
+    {
+        decoded.error = "unknown command";
+    }
+
+    return decoded;
+}
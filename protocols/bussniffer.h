@@ -0,0 +1,97 @@
+#ifndef BUSSNIFFER_H
+#define BUSSNIFFER_H
+
+#include <QObject>
+#include <QIODevice>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMap>
+#include <QTimer>
+
+/**
+ * Passive (receive-only) sniffer of a RS485 or Seriobus line.
+ *
+ * The received bytes are read in bulk and time stamped with a monotonic
+ * clock at read time; the bytes of a chunk are stamped back from the read
+ * time by the byte time of the line. Frames (STX ... ETX) of all participants
+ * are reassembled and decoded, responses (ACK, NACK, EOT) are attributed to
+ * the destination of the preceding frame. Each event is written to the
+ * capture file and, if live, to the console. Statistics are kept per source.
+ *
+ * Capture file: one event per line, tab separated:
+ *   <time us> <kind> <raw hex> <decoded>
+ */
+class BusSniffer : public QObject
+{
+    Q_OBJECT
+public:
+    struct sDecoded {
+        uchar cmd;
+        uchar sender;           // sender ASW
+        QString source;         // LR-address (0x28) or sender ASW
+        QString destination;    // LR-address, group
+        QString text;           // payload, blink bits removed
+        QString error;          // empty if the frame is valid
+    };
+
+    struct sStats {
+        quint64 frames;
+        quint64 invalid;
+        quint64 ack;
+        quint64 nack;
+        quint64 bytes;
+        qint64 lastSeen;        // time of the last event in us
+    };
+
+    explicit BusSniffer(QObject *parent = 0);
+
+    void setDevice(QIODevice *device);
+    void setByteTime(qint64 nsec) { mByteTime = nsec; }
+    void setLive(bool live) { mIsLive = live; }
+    void setReportInterval(int msec) { mReportTimer.setInterval(msec); }
+    bool setCaptureFile(const QString &fileName);
+
+    const QMap<QString, sStats> &statistics() const { return mStats; }
+    quint64 garbage() const { return mCntGarbage; }
+    void report() const;
+
+    static sDecoded decode(const QByteArray &frame);
+    static QByteArray unblink(const QByteArray &text);
+
+signals:
+    void frameDecoded(qint64 time, const QByteArray &frame);
+    void finished();
+
+public slots:
+    void start(qint64 duration);
+    void stop();
+
+private slots:
+    void onReadyRead();
+    void onReportTimeout();
+
+private:
+    static const int MAX_FRAME = 256;
+
+    QIODevice *mDevice;
+    QElapsedTimer mClock;
+    QTimer mEndTimer;
+    QTimer mReportTimer;
+    QFile mCapture;
+    bool mIsLive;
+    bool mIsRunning;
+    qint64 mByteTime;           // ns per byte on the line
+    qint64 mLastTime;           // ns, time stamp of the last byte
+    QByteArray mFrame;          // frame being received
+    qint64 mFrameTime;          // ns, time stamp of STX
+    QString mLastDestination;   // destination of the last frame, source of its response
+    quint64 mCntGarbage;        // bytes outside of frames
+    QMap<QString, sStats> mStats;
+
+    void onFrame(qint64 time, const QByteArray &frame);
+    void onResponse(qint64 time, char response);
+    void write(qint64 time, const char *kind, const QByteArray &raw, const QString &decoded);
+    sStats &stats(const QString &source, qint64 time);
+};
+
+#endif // BUSSNIFFER_H
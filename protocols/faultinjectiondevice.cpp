@@ -0,0 +1,194 @@
+#include "faultinjectiondevice.h"
+#include <QStringList>
+#include <QDebug>
+
+FaultInjectionDevice::FaultInjectionDevice(QIODevice *device, quint64 seed, QObject *parent) :
+    QIODevice(parent), mRandom(seed)
+{
+    mDevice = device;
+    mClock = Clock::system();
+    mFaults = sFaults();
+    mCounters = sCounters();
+    mSilenceUntil = -1;
+
+    mTxTimer.setSingleShot(true);
+    mRxTimer.setSingleShot(true);
+
+    connect(&mTxTimer, SIGNAL(timeout()), this, SLOT(deliverTx()));
+    connect(&mRxTimer, SIGNAL(timeout()), this, SLOT(deliverRx()));
+    connect(mDevice, SIGNAL(readyRead()), this, SLOT(onDeviceReadyRead()));
+}
+
+void FaultInjectionDevice::setClock(Clock *clock)
+{
+    mClock = clock ? clock : Clock::system();
+    mTxTimer.setClock(clock);
+    mRxTimer.setClock(clock);
+}
+
+// return true on errors
+bool FaultInjectionDevice::parseFaults(const QString &spec, sFaults &faults)
+{
+    faults = sFaults();
+
+    foreach (const QString &item, spec.split(",", QString::SkipEmptyParts))
+    {
+        QString key = item.section("=", 0, 0).trimmed();
+        bool ok;
+        double value = item.section("=", 1).toDouble(&ok);
+
+        if (!ok)
+        {
+            qWarning() << "invalid fault" << item;
+            return true;
+        }
+
+        if (key == "drop")
+            faults.drop = value;
+        else if (key == "flip")
+            faults.flip = value;
+        else if (key == "dup")
+            faults.duplicate = value;
+        else if (key == "latency")
+            faults.latency = value;
+        else if (key == "jitter")
+            faults.jitter = value;
+        else if (key == "silence")
+            faults.silence = value;
+        else if (key == "silenceMs")
+            faults.silenceLength = value;
+        else
+        {
+            qWarning() << "unknown fault" << key;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// the wrapped device is opened by its owner
+bool FaultInjectionDevice::open(OpenMode mode)
+{
+    return QIODevice::open(mode) && mDevice->isOpen();
+}
+
+void FaultInjectionDevice::close()
+{
+    mTxTimer.stop();
+    mRxTimer.stop();
+    mTxQueue.clear();
+    mRxQueue.clear();
+    mRxBuffer.clear();
+
+    QIODevice::close();
+}
+
+// apply faults to the bytes and queue them for delivery
+void FaultInjectionDevice::impair(const char *data, qint64 size, DelayQueue &queue, ClockTimer &timer)
+{
+    qint64 now = mClock->now();
+    QByteArray bytes;
+
+    for (qint64 i = 0; i < size; ++i)
+    {
+        char c = data[i];
+
+        ++mCounters.bytes;
+
+        if ((mSilenceUntil < now) && (mRandom.real() < mFaults.silence))
+            mSilenceUntil = now + mFaults.silenceLength;
+
+        if (mSilenceUntil >= now)
+        {
+            ++mCounters.silenced;
+            continue;
+        }
+
+        if (mRandom.real() < mFaults.drop)
+        {
+            ++mCounters.dropped;
+            continue;
+        }
+
+        if (mRandom.real() < mFaults.flip)
+        {
+            c ^= 1 << mRandom.bounded(8);
+            ++mCounters.flipped;
+        }
+
+        bytes.append(c);
+
+        if (mRandom.real() < mFaults.duplicate)
+        {
+            bytes.append(c);
+            ++mCounters.duplicated;
+        }
+    }
+
+    if (bytes.isEmpty())
+        return;
+
+    // bytes keep their order, i.e., jitter does not overtake queued bytes
+    qint64 due = now + mFaults.latency + mRandom.bounded(mFaults.jitter + 1);
+
+    if (!queue.isEmpty())
+        due = qMax(due, queue.last().first);
+
+    queue.append(qMakePair(due, bytes));
+
+    if (!timer.isActive())
+        timer.start(due - now);
+}
+
+// take bytes due up to now from the queue and schedule the next delivery
+qint64 FaultInjectionDevice::deliver(DelayQueue &queue, ClockTimer &timer, QByteArray &bytes)
+{
+    qint64 now = mClock->now();
+
+    while (!queue.isEmpty() && (queue.first().first <= now))
+        bytes.append(queue.takeFirst().second);
+
+    if (!queue.isEmpty())
+        timer.start(queue.first().first - now);
+
+    return bytes.length();
+}
+
+void FaultInjectionDevice::deliverTx()
+{
+    QByteArray bytes;
+
+    if (deliver(mTxQueue, mTxTimer, bytes))
+        mDevice->write(bytes);
+}
+
+void FaultInjectionDevice::deliverRx()
+{
+    if (deliver(mRxQueue, mRxTimer, mRxBuffer))
+        emit readyRead();
+}
+
+void FaultInjectionDevice::onDeviceReadyRead()
+{
+    QByteArray bytes = mDevice->readAll();
+
+    impair(bytes.constData(), bytes.length(), mRxQueue, mRxTimer);
+}
+
+qint64 FaultInjectionDevice::readData(char *data, qint64 maxSize)
+{
+    qint64 size = qMin(maxSize, qint64(mRxBuffer.length()));
+
+    memcpy(data, mRxBuffer.constData(), size);
+    mRxBuffer.remove(0, size);
+
+    return size;
+}
+
+qint64 FaultInjectionDevice::writeData(const char *data, qint64 maxSize)
+{
+    impair(data, maxSize, mTxQueue, mTxTimer);
+
+    return maxSize;
+}
@@ -0,0 +1,86 @@
+#ifndef FAULTINJECTIONDEVICE_H
+#define FAULTINJECTIONDEVICE_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <clock.h>
+#include <xorshift.h>
+
+/**
+ * Device wrapper impairing the link to the wrapped (serial or simulated) device.
+ *
+ * Bytes in both directions are dropped, bit flipped or duplicated with given
+ * probabilities, delayed by latency plus random jitter, and lost during
+ * bursts of silence. Faults are reproducible from the seed.
+ *
+ * Faults are configured by a spec, e.g.
+ *   "drop=0.001,flip=0.0005,dup=0.0001,latency=5,jitter=3,silence=0.0001,silenceMs=200"
+ * where probabilities are per byte, times in ms.
+ */
+class FaultInjectionDevice : public QIODevice
+{
+    Q_OBJECT
+public:
+    struct sFaults {
+        double drop;
+        double flip;
+        double duplicate;
+        int latency;
+        int jitter;
+        double silence;     // probability of a burst of silence per byte
+        int silenceLength;
+    };
+
+    struct sCounters {
+        quint64 bytes;
+        quint64 dropped;
+        quint64 flipped;
+        quint64 duplicated;
+        quint64 silenced;
+    };
+
+    FaultInjectionDevice(QIODevice *device, quint64 seed, QObject *parent = 0);
+
+    void setClock(Clock *clock);
+    void setFaults(const sFaults &faults) { mFaults = faults; }
+    const sCounters &counters() const { return mCounters; }
+
+    static bool parseFaults(const QString &spec, sFaults &faults);
+
+    bool open(OpenMode mode);
+    void close();
+    bool isSequential() const { return true; }
+    qint64 bytesAvailable() const { return mRxBuffer.length() + QIODevice::bytesAvailable(); }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize);
+    qint64 writeData(const char *data, qint64 maxSize);
+
+private slots:
+    void onDeviceReadyRead();
+    void deliverTx();
+    void deliverRx();
+
+private:
+    typedef QList<QPair<qint64, QByteArray> > DelayQueue;  // (due, bytes)
+
+    QIODevice *mDevice;
+    Clock *mClock;
+    XorShift mRandom;
+    sFaults mFaults;
+    sCounters mCounters;
+    qint64 mSilenceUntil;
+
+    DelayQueue mTxQueue;
+    DelayQueue mRxQueue;
+    ClockTimer mTxTimer;
+    ClockTimer mRxTimer;
+    QByteArray mRxBuffer;
+
+    void impair(const char *data, qint64 size, DelayQueue &queue, ClockTimer &timer);
+    qint64 deliver(DelayQueue &queue, ClockTimer &timer, QByteArray &bytes);
+};
+
+#endif // FAULTINJECTIONDEVICE_H
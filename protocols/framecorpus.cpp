@@ -0,0 +1,177 @@
+#include "framecorpus.h"
+#include <QDebug>
+#include <QtEndian>
+
+static const quint32 CORPUS_MAGIC = 0x43464446;  // "FDFC"
+static const quint32 CORPUS_VERSION = 2;
+
+FrameCorpus::FrameCorpus()
+{
+    mData = 0;
+    mIndex = 0;
+    mCntPatterns = 0;
+    mFingerprint = 0;
+    mCntWritten = 0;
+}
+
+FrameCorpus::~FrameCorpus()
+{
+    close();
+}
+
+// return true on errors
+bool FrameCorpus::create(const QString &fileName, const QList<uchar> &commands, quint64 cntPatterns, quint32 fingerprint)
+{
+    close();
+
+    mFile.setFileName(fileName);
+
+    if (!mFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "cannot create frame corpus" << fileName;
+        return true;
+    }
+
+    mCommands = commands;
+    mCntPatterns = cntPatterns;
+    mFingerprint = fingerprint;
+    mCntWritten = 0;
+    mWriteIndex.clear();
+
+    QByteArray header(HEADER_SIZE, 0);  // written on finish
+
+    mFile.write(header);
+
+    foreach (uchar cmd, mCommands)
+        mFile.putChar(cmd);
+
+    return false;
+}
+
+// return true on errors
+bool FrameCorpus::append(const QByteArray &frame)
+{
+    uchar entry[INDEX_ENTRY_SIZE];
+
+    qToLittleEndian<quint64>(mFile.pos(), entry);
+    qToLittleEndian<quint32>(frame.length(), entry + 8);
+    mWriteIndex.append((const char *)entry, INDEX_ENTRY_SIZE);
+
+    ++mCntWritten;
+
+    return mFile.write(frame) != frame.length();
+}
+
+// return true on errors
+bool FrameCorpus::finish()
+{
+    uchar header[HEADER_SIZE];
+    quint64 indexOffset = mFile.pos();
+    bool error = (mCntWritten != count());
+
+    if (error)
+        qWarning() << "frame corpus: written" << mCntWritten << "of" << count() << "frames";
+
+    error |= (mFile.write(mWriteIndex) != mWriteIndex.length());
+
+    qToLittleEndian<quint32>(CORPUS_MAGIC, header);
+    qToLittleEndian<quint32>(CORPUS_VERSION, header + 4);
+    qToLittleEndian<quint32>(mCommands.count(), header + 8);
+    qToLittleEndian<quint64>(mCntPatterns, header + 12);
+    qToLittleEndian<quint64>(indexOffset, header + 20);
+    qToLittleEndian<quint32>(mFingerprint, header + 28);
+
+    error |= !mFile.seek(0);
+    error |= (mFile.write((const char *)header, HEADER_SIZE) != HEADER_SIZE);
+
+    mFile.close();
+    mWriteIndex.clear();
+
+    return error;
+}
+
+// return true on errors
+bool FrameCorpus::open(const QString &fileName)
+{
+    close();
+
+    mFile.setFileName(fileName);
+
+    if (!mFile.open(QIODevice::ReadOnly) || (mFile.size() < HEADER_SIZE))
+    {
+        qWarning() << "cannot open frame corpus" << fileName;
+        return true;
+    }
+
+    mData = mFile.map(0, mFile.size());
+
+    if (!mData)
+    {
+        qWarning() << "cannot map frame corpus" << fileName;
+        close();
+        return true;
+    }
+
+    quint32 cntCommands = qFromLittleEndian<quint32>(mData + 8);
+    quint64 indexOffset = qFromLittleEndian<quint64>(mData + 20);
+
+    mCntPatterns = qFromLittleEndian<quint64>(mData + 12);
+    mFingerprint = qFromLittleEndian<quint32>(mData + 28);
+
+    if ((qFromLittleEndian<quint32>(mData) != CORPUS_MAGIC) ||
+            (qFromLittleEndian<quint32>(mData + 4) != CORPUS_VERSION) ||
+            (quint64(HEADER_SIZE) + cntCommands > indexOffset) ||
+            (indexOffset + cntCommands * mCntPatterns * INDEX_ENTRY_SIZE > quint64(mFile.size())))
+    {
+        qWarning() << "invalid frame corpus" << fileName;
+        close();
+        return true;
+    }
+
+    for (quint32 i = 0; i < cntCommands; ++i)
+        mCommands << mData[HEADER_SIZE + i];
+
+    mIndex = mData + indexOffset;
+
+    return false;
+}
+
+void FrameCorpus::close()
+{
+    if (mData)
+        mFile.unmap(mData);
+
+    if (mFile.isOpen())
+        mFile.close();
+
+    mData = 0;
+    mIndex = 0;
+    mCommands.clear();
+    mCntPatterns = 0;
+    mFingerprint = 0;
+}
+
+QByteArray FrameCorpus::frame(quint64 idx) const
+{
+    if (!mData || (idx >= count()))
+        return QByteArray();
+
+    const uchar *entry = mIndex + idx * INDEX_ENTRY_SIZE;
+    quint64 offset = qFromLittleEndian<quint64>(entry);
+    quint32 length = qFromLittleEndian<quint32>(entry + 8);
+
+    if (offset + length > quint64(mFile.size()))
+        return QByteArray();
+
+    return QByteArray::fromRawData((const char *)mData + offset, length);
+}
+
+QByteArray FrameCorpus::frame(uchar cmd, quint64 id) const
+{
+    int cmdIdx = mCommands.indexOf(cmd);
+
+    if ((cmdIdx < 0) || !id || (id > mCntPatterns))
+        return QByteArray();
+
+    return frame(cmdIdx * mCntPatterns + id - 1);
+}
@@ -0,0 +1,59 @@
+#ifndef FRAMECORPUS_H
+#define FRAMECORPUS_H
+
+#include <QFile>
+#include <QByteArray>
+#include <QList>
+
+/**
+ * File of precompiled frames (STX, hex coded protocol, ETX) of a test suite.
+ *
+ * Layout (little endian):
+ *  - header: magic, version, number of commands, number of patterns, offset of index,
+ *    fingerprint of the test cycle the frames were encoded for
+ *  - commands: one byte per command
+ *  - frames: frames of all patterns of the 1st command, then of the 2nd command, ...
+ *  - index: offset (64 bits) and length (32 bits) of each frame
+ *
+ * The reader maps the file into memory, frames are returned without copying.
+ */
+class FrameCorpus
+{
+public:
+    FrameCorpus();
+    ~FrameCorpus();
+
+    // writer
+    bool create(const QString &fileName, const QList<uchar> &commands, quint64 cntPatterns, quint32 fingerprint);
+    bool append(const QByteArray &frame);
+    bool finish();
+
+    // reader
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const { return mData != 0; }
+
+    QList<uchar> commands() const { return mCommands; }
+    quint64 patternCount() const { return mCntPatterns; }
+    quint32 fingerprint() const { return mFingerprint; }
+    quint64 count() const { return mCommands.count() * mCntPatterns; }
+
+    QByteArray frame(quint64 idx) const;
+    QByteArray frame(uchar cmd, quint64 id) const;     // id = 1 .. patternCount()
+
+private:
+    QFile mFile;
+    uchar *mData;               // mapped file
+    const uchar *mIndex;        // index in mapped file
+    QList<uchar> mCommands;
+    quint64 mCntPatterns;
+    quint32 mFingerprint;
+
+    QByteArray mWriteIndex;     // index, while writing
+    quint64 mCntWritten;
+
+    static const int HEADER_SIZE = 4 + 4 + 4 + 8 + 8 + 4;
+    static const int INDEX_ENTRY_SIZE = 8 + 4;
+};
+
+#endif // FRAMECORPUS_H
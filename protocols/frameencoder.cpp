@@ -0,0 +1,148 @@
+#include "frameencoder.h"
+#include <serialprotocol.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define FD_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define FD_AVX2
+#include <immintrin.h>
+#endif
+
+static const char BLINK_BIT = char(0x80);   // fd::BLINK_CHAR
+
+// set blink bit of each char
+void FrameEncoder::setBlink(char *data, int length)
+{
+    int i = 0;
+
+#if defined(FD_AVX2)
+    const __m256i blink256 = _mm256_set1_epi8(BLINK_BIT);
+
+    for (; i + 32 <= length; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+        _mm256_storeu_si256((__m256i *)(data + i), _mm256_or_si256(v, blink256));
+    }
+#endif
+#if defined(FD_SSE2)
+    const __m128i blink = _mm_set1_epi8(BLINK_BIT);
+
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        _mm_storeu_si128((__m128i *)(data + i), _mm_or_si128(v, blink));
+    }
+#endif
+
+    for (; i < length; ++i)
+        data[i] |= BLINK_BIT;
+}
+
+// XOR of all bytes
+uchar FrameEncoder::checksum(const char *data, int length)
+{
+    uchar crc = 0;
+    int i = 0;
+
+#if defined(FD_SSE2)
+    if (length >= 16)
+    {
+        __m128i acc = _mm_setzero_si128();
+
+#if defined(FD_AVX2)
+        __m256i acc256 = _mm256_setzero_si256();
+
+        for (; i + 32 <= length; i += 32)
+            acc256 = _mm256_xor_si256(acc256, _mm256_loadu_si256((const __m256i *)(data + i)));
+
+        acc = _mm_xor_si128(_mm256_castsi256_si128(acc256), _mm256_extracti128_si256(acc256, 1));
+#endif
+        for (; i + 16 <= length; i += 16)
+            acc = _mm_xor_si128(acc, _mm_loadu_si128((const __m128i *)(data + i)));
+
+        acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 8));
+        acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 4));
+        acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 2));
+        acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 1));
+
+        crc = _mm_cvtsi128_si32(acc) & 0xFF;
+    }
+#endif
+
+    for (; i < length; ++i)
+        crc ^= data[i];
+
+    return crc;
+}
+
+// dst must hold 2 * length chars
+void FrameEncoder::toHex(const char *src, int length, char *dst, bool upper)
+{
+    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    int i = 0;
+
+#if defined(FD_SSE2)
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i letter = _mm_set1_epi8(upper ? ('A' - '0' - 10) : ('a' - '0' - 10));
+
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+        __m128i lo = _mm_and_si128(v, nibble);
+
+        hi = _mm_add_epi8(_mm_add_epi8(hi, zero), _mm_and_si128(_mm_cmpgt_epi8(hi, nine), letter));
+        lo = _mm_add_epi8(_mm_add_epi8(lo, zero), _mm_and_si128(_mm_cmpgt_epi8(lo, nine), letter));
+
+        _mm_storeu_si128((__m128i *)(dst + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *)(dst + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+#endif
+
+    for (; i < length; ++i)
+    {
+        uchar c = src[i];
+        dst[2 * i] = digits[c >> 4];
+        dst[2 * i + 1] = digits[c & 0x0F];
+    }
+}
+
+QByteArray FrameEncoder::toHex(const QByteArray &data, bool upper)
+{
+    QByteArray hex(2 * data.length(), Qt::Uninitialized);
+
+    toHex(data.constData(), data.length(), hex.data(), upper);
+    return hex;
+}
+
+// STX, [special char,] hex coded protocol, ETX
+QByteArray FrameEncoder::frame(const QByteArray &protocol)
+{
+    int offset = 0;
+    bool upper = false;
+
+    if ((protocol.length() > 1) && protocol.at(0) && (protocol.at(1) & 0x80))  // msg started with special char, i.e., 'W'
+    {
+        offset = 1;
+        upper = true;
+    }
+
+    int length = protocol.length() - offset;
+    QByteArray frame(1 + offset + 2 * length + 1, Qt::Uninitialized);
+    char *dst = frame.data();
+
+    *dst++ = SerialProtocol::STX;
+
+    if (offset)
+        *dst++ = protocol.at(0);
+
+    toHex(protocol.constData() + offset, length, dst, upper);
+    dst[2 * length] = SerialProtocol::ETX;
+
+    return frame;
+}
@@ -0,0 +1,23 @@
+#ifndef FRAMEENCODER_H
+#define FRAMEENCODER_H
+
+#include <QByteArray>
+
+/**
+ * Bulk operations used to encode LR protocols and serial frames.
+ *
+ * Blink masking, XOR checksum and hex expansion are vectorised with
+ * SSE2 (AVX2 if enabled by the compiler), a scalar loop is used otherwise.
+ */
+class FrameEncoder
+{
+public:
+    static void setBlink(char *data, int length);
+    static uchar checksum(const char *data, int length);
+    static void toHex(const char *src, int length, char *dst, bool upper = false);
+
+    static QByteArray toHex(const QByteArray &data, bool upper = false);
+    static QByteArray frame(const QByteArray &protocol);
+};
+
+#endif // FRAMEENCODER_H
@@ -1,5 +1,15 @@
 SOURCES += \
-    $$PWD/serialprotocol.cpp
+    $$PWD/serialprotocol.cpp \
+    $$PWD/framecorpus.cpp \
+    $$PWD/frameencoder.cpp \
+    $$PWD/simulateddevice.cpp \
+    $$PWD/faultinjectiondevice.cpp \
+    $$PWD/bussniffer.cpp
 
 HEADERS  += \
-    $$PWD/serialprotocol.h
+    $$PWD/serialprotocol.h \
+    $$PWD/framecorpus.h \
+    $$PWD/frameencoder.h \
+    $$PWD/simulateddevice.h \
+    $$PWD/faultinjectiondevice.h \
+    $$PWD/bussniffer.h
@@ -1,4 +1,6 @@
 #include "serialprotocol.h"
+#include <ctype.h>
+#include "frameencoder.h"
 
 SerialProtocol::SerialProtocol()
 {
@@ -70,15 +72,18 @@ void SerialProtocol::onReadyRead()
             break;
 
         case STX:
+            mRecvProtocol.clear();
             emit receivedSTX();
             break;
 
         case ETX:
             emit receivedETX();
+            mRecvProtocol.clear();
             break;
 
         default:
-            mRecvProtocol.append(mLastByte);
+            if (mRecvProtocol.length() < MAX_RECV_PROTOCOL)  // received bytes are capped, garbage without ETX cannot grow the buffer
+                mRecvProtocol.append(mLastByte);
             break;
         }
     }
@@ -92,26 +97,76 @@ void SerialProtocol::sendProtocol(const QByteArray &protocol)
         return;
     }
 
-    mSendQueue.push_back(protocol);
+    sSendItem item;
+    item.data = protocol;
+    item.isFrame = false;
+
+    mSendQueue.push_back(item);
     emit requestSend();
 }
 
+// frame (STX, hex coded protocol, ETX) is sent without copying, i.e., from a mapped frame corpus
+void SerialProtocol::sendFrame(const QByteArray &frame)
+{
+    if(!(mDevice && mDevice->isOpen()))
+    {
+        qWarning()<<"Tried to send protocol while disconnected";
+        return;
+    }
+
+    sSendItem item;
+    item.data = frame;
+    item.isFrame = true;
+
+    mSendQueue.push_back(item);
+    emit requestSend();
+}
+
+QByteArray SerialProtocol::frame(const QByteArray &protocol)
+{
+    return FrameEncoder::frame(protocol);
+}
+
+// return protocol (without special char) of the frame
+QByteArray SerialProtocol::unframe(const QByteArray &frame)
+{
+    int begin = frame.indexOf(STX) + 1;
+    int end = frame.lastIndexOf(ETX);
+
+    if (end < begin)
+        end = frame.length();
+
+    if ((begin < end) && !isxdigit((uchar)frame.at(begin)))  // special char
+        ++begin;
+
+    return QByteArray::fromHex(frame.mid(begin, end - begin));
+}
+
 void SerialProtocol::checkSendQueue()
 {
     QByteArray snd;
+    const QByteArray &front = mSendQueue.front().data;
 
-    if (mSendQueue.front().at(0) && (mSendQueue.front().at(1) & 0x80))  // msg started with special char, i.e., 'W'
+    if (mSendQueue.front().isFrame)
     {
-        snd = mSendQueue.front().mid(1);
-        qDebug() << "serial protocol (hex) " << snd.toHex().toUpper();
+        emit sentFrame(front);
     }
     else
     {
-        snd = mSendQueue.front();
-        qDebug() << "serial protocol (hex) " << snd.toHex();
+        if (front.at(0) && (front.at(1) & 0x80))  // msg started with special char, i.e., 'W'
+        {
+            snd = front.mid(1);
+            qDebug() << "serial protocol (hex) " << snd.toHex().toUpper();
+        }
+        else
+        {
+            snd = front;
+            qDebug() << "serial protocol (hex) " << snd.toHex();
+        }
+
+        emit sent(snd);
     }
 
-    emit sent(snd);
     mSendQueue.pop_front();
 
     mTransmitTimeout.stop();
@@ -132,18 +187,30 @@ void SerialProtocol::startSend()
         return;
     }
 
-    if (!mTransmitTimeout.isActive())
+    if (!mTransmitTimeout.isActive() && mSendQueue.front().isFrame)
+    {
+        const QByteArray &frame = mSendQueue.front().data;
+
+        emit startedSend();
+        mDevice->write(frame.constData(), frame.length());
+
+        mTransmitTimeout.setInterval((frame.length() * mSerialFrame)/mSerialDataRate + 1);
+        mTransmitTimeout.start();
+    }
+    else if (!mTransmitTimeout.isActive())
     {
         QByteArray snd;
         char ctrlByte = 0;
 
-        if (mSendQueue.front().at(0) && (mSendQueue.front().at(1) & 0x80))  // msg started with special char, i.e., 'W'
+        emit startedSend();
+
+        if (mSendQueue.front().data.at(0) && (mSendQueue.front().data.at(1) & 0x80))  // msg started with special char, i.e., 'W'
         {
-            snd = mSendQueue.front().mid(1);
-            ctrlByte = mSendQueue.front().at(0);
+            snd = mSendQueue.front().data.mid(1);
+            ctrlByte = mSendQueue.front().data.at(0);
         }
         else
-            snd = mSendQueue.front();
+            snd = mSendQueue.front().data;
 
         char c=STX;
         mDevice->write(&c,1);
@@ -153,12 +220,12 @@ void SerialProtocol::startSend()
         {
             mDevice->write(&ctrlByte, 1);
             ++bytes;
-            mDevice->write(snd.toHex().toUpper());
         }
-        else
-            mDevice->write(snd.toHex());
 
-        bytes += snd.toHex().length();
+        QByteArray hex = FrameEncoder::toHex(snd, ctrlByte != 0);
+
+        mDevice->write(hex);
+        bytes += hex.length();
 
         c=ETX;
         mDevice->write(&c,1);
@@ -178,3 +245,10 @@ void SerialProtocol::setSerialDataRate(int rate)
 {
     mSerialDataRate = rate;
 }
+
+// frame time model of the line: bits per second and bits per byte (start, data, parity, stop)
+void SerialProtocol::setSerialFormat(int rate, int dataBits, bool isParity, int stopBits)
+{
+    setSerialDataRate(rate);
+    setSerialFrame(bitsPerByte(dataBits, isParity, stopBits));
+}
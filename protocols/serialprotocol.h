@@ -5,6 +5,7 @@
 #include <QList>
 #include <QIODevice>
 #include <QTimer>
+#include <clock.h>
 
 #include <QDebug>
 
@@ -18,6 +19,12 @@ public:
     QIODevice* getDevice();
     void setSerialFrame(int frame);
     void setSerialDataRate(int rate);
+    void setSerialFormat(int rate, int dataBits, bool isParity, int stopBits);
+    void setClock(Clock *clock) { mTransmitTimeout.setClock(clock); }
+
+    static QByteArray frame(const QByteArray &protocol);
+    static QByteArray unframe(const QByteArray &frame);
+    static int bitsPerByte(int dataBits, bool isParity, int stopBits) { return 1 + dataBits + isParity + stopBits; }
 
     static const char STX = 0x02;
     static const char ETX = 0x03;
@@ -34,12 +41,15 @@ signals:
     void receivedByte();
     void receivedNonControl();
 
+    void startedSend();         // transmission of the front item begins, sent() or sentFrame() follows at its end
     void sent(QByteArray byte);
+    void sentFrame(QByteArray frame);
     void requestSend();
     void nothingToSend();
 
 public slots:
     void sendProtocol(const QByteArray &protocol);
+    void sendFrame(const QByteArray &frame);
 
 private slots:
     void onReadyRead();
@@ -48,11 +58,17 @@ private slots:
     void startSend();
 
 private:
-    QList<QByteArray> mSendQueue;
+    struct sSendItem {
+        QByteArray data;
+        bool isFrame;       // data is a complete frame, sent as it is
+    };
+
+    QList<sSendItem> mSendQueue;
     QIODevice* mDevice;
     char mLastByte;
-    QByteArray mRecvProtocol;
-    QTimer mTransmitTimeout;    // timer used to control transmission duration
+    QByteArray mRecvProtocol;   // bytes of the received frame
+    static const int MAX_RECV_PROTOCOL = 256;
+    ClockTimer mTransmitTimeout;    // timer used to control transmission duration
     int mSerialDataRate;        // bits per second
     int mSerialFrame;           // bits per byte
 };
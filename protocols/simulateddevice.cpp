@@ -0,0 +1,166 @@
+#include "simulateddevice.h"
+#include "serialprotocol.h"
+#include "frameencoder.h"
+#include <ctype.h>
+#include <fd.h>
+
+using namespace fd;
+
+SimulatedDevice::SimulatedDevice(Clock *clock, QObject *parent) :
+    QIODevice(parent)
+{
+    mResponse = SerialProtocol::ACK;
+    mValidate = false;
+    mByteTime = 0;
+    mResponseDelay = 20;
+    mCntFrames = 0;
+    mCntRejected = 0;
+
+    mResponseTimer.setClock(clock);
+    mResponseTimer.setSingleShot(true);
+    connect(&mResponseTimer, SIGNAL(timeout()), this, SLOT(respond()));
+}
+
+qint64 SimulatedDevice::readData(char *data, qint64 maxSize)
+{
+    qint64 size = qMin(maxSize, qint64(mTxBuffer.length()));
+
+    memcpy(data, mTxBuffer.constData(), size);
+    mTxBuffer.remove(0, size);
+
+    return size;
+}
+
+qint64 SimulatedDevice::writeData(const char *data, qint64 maxSize)
+{
+    for (qint64 i = 0; i < maxSize; ++i)
+    {
+        if (data[i] == SerialProtocol::STX)
+            mRxFrame.clear();
+
+        mRxFrame.append(data[i]);
+
+        if (data[i] == SerialProtocol::ETX)
+        {
+            mLastFrame = mRxFrame;
+            mRxFrame.clear();
+            ++mCntFrames;
+
+            if (!isAddressed(mLastFrame))
+            {
+                // display not on the segment, no response
+            }
+            else if (mValidate && !isValid(mLastFrame))
+            {
+                ++mCntRejected;
+                mPending.append(SerialProtocol::NACK);
+            }
+            else if (mResponse)
+            {
+                mPending.append(mResponse);
+            }
+
+            emit frameReceived(mLastFrame);
+
+            if (!mPending.isEmpty() && !mResponseTimer.isActive())
+                mResponseTimer.start(mResponseDelay + int(mLastFrame.length() * mByteTime / 1000));
+        }
+    }
+
+    return maxSize;
+}
+
+void SimulatedDevice::respond()
+{
+    mTxBuffer.append(mPending);
+    mPending.clear();
+
+    if (!mTxBuffer.isEmpty())
+        emit readyRead();
+}
+
+// frame: STX, optional special char, hex coded protocol, ETX
+QByteArray SimulatedDevice::protocolOf(const QByteArray &frame)
+{
+    int begin = 1;
+    int end = frame.length() - 1;
+
+    if ((begin < end) && !isxdigit((uchar)frame.at(begin)))  // special char
+        ++begin;
+
+    return QByteArray::fromHex(frame.mid(begin, end - begin));
+}
+
+// frame is answered by one of the displays of the segment
+bool SimulatedDevice::isAddressed(const QByteArray &frame) const
+{
+    if (mAddresses.isEmpty())
+        return true;
+
+    QByteArray protocol = protocolOf(frame);
+
+    if ((protocol.length() <= PROT_28_DST_RM) || ((uchar)protocol.at(PROT_HDR_CMD) != LR_CMD_28))
+        return true;
+
+    uchar st = protocol.at(PROT_28_DST_ST);
+    uchar rm = protocol.at(PROT_28_DST_RM);
+
+    if (!st)                                            // all displays
+        return true;
+
+    if (!rm)                                            // all rooms of the station
+    {
+        foreach (quint16 addr, mAddresses)
+        {
+            if ((addr >> 8) == st)
+                return true;
+        }
+
+        return false;
+    }
+
+    return mAddresses.contains((st << 8) | rm);
+}
+
+// frame: STX, optional special char, hex coded protocol, ETX
+bool SimulatedDevice::isValid(const QByteArray &frame)
+{
+    int begin = 1;
+    int end = frame.length() - 1;
+
+    if ((frame.length() < 2) || (frame.at(0) != SerialProtocol::STX) || (frame.at(end) != SerialProtocol::ETX))
+        return false;
+
+    if ((begin < end) && !isxdigit((uchar)frame.at(begin)))  // special char
+        ++begin;
+
+    if ((end - begin) % 2)
+        return false;
+
+    for (int i = begin; i < end; ++i)
+    {
+        if (!isxdigit((uchar)frame.at(i)))
+            return false;
+    }
+
+    QByteArray protocol = QByteArray::fromHex(frame.mid(begin, end - begin));
+
+    if (protocol.length() <= PROT_HDR_CMD)
+        return false;
+
+    if ((uchar)protocol.at(PROT_HDR_CMD) == LR_CMD_28)
+    {
+        if (protocol.length() <= PROT_28_PL_LENGTH)     // short header
+            return false;
+
+        int length = (uchar)protocol.at(PROT_28_PL_LENGTH);
+
+        if (protocol.length() != PROT_28_PL_DATA + length + 1)     // payload, crc
+            return false;
+
+        if (FrameEncoder::checksum(protocol.constData() + PROT_28_PL_DATA, length) != (uchar)protocol.at(protocol.length() - 1))
+            return false;
+    }
+
+    return true;
+}
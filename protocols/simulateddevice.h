@@ -0,0 +1,71 @@
+#ifndef SIMULATEDDEVICE_H
+#define SIMULATEDDEVICE_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QSet>
+#include <clock.h>
+
+/**
+ * Serial device emulating a Flurdisplay on a clock.
+ *
+ * Each received frame (STX ... ETX) is answered with a response byte (ACK by
+ * default) after the response delay, plus the time to receive the frame
+ * if a line rate is set. If validation is enabled, malformed
+ * frames (non hex data, wrong payload length or checksum of 0x28) are
+ * answered with NACK. Together with a virtual clock, test cycles run without
+ * hardware as fast as the CPU allows.
+ *
+ * With a set of LR-addresses, the device emulates the displays of a RS485
+ * segment: frames of protocol 0x28 to other addresses are not answered.
+ */
+class SimulatedDevice : public QIODevice
+{
+    Q_OBJECT
+public:
+    explicit SimulatedDevice(Clock *clock, QObject *parent = 0);
+
+    void setResponseDelay(int msec) { mResponseDelay = msec; }
+    void setLineRate(int rate, int bitsPerByte) { mByteTime = 1000000LL * bitsPerByte / qMax(1, rate); }
+    void setResponse(char response) { mResponse = response; }   // 0: no response
+    void setValidate(bool validate) { mValidate = validate; }
+    void setAddresses(const QSet<quint16> &addresses) { mAddresses = addresses; }  // empty: all
+
+    quint64 framesReceived() const { return mCntFrames; }
+    quint64 framesRejected() const { return mCntRejected; }
+    const QByteArray &lastFrame() const { return mLastFrame; }
+
+    bool isSequential() const { return true; }
+    qint64 bytesAvailable() const { return mTxBuffer.length() + QIODevice::bytesAvailable(); }
+
+signals:
+    void frameReceived(QByteArray frame);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize);
+    qint64 writeData(const char *data, qint64 maxSize);
+
+private slots:
+    void respond();
+
+private:
+    static bool isValid(const QByteArray &frame);
+    static QByteArray protocolOf(const QByteArray &frame);
+    bool isAddressed(const QByteArray &frame) const;
+
+private:
+    ClockTimer mResponseTimer;
+    int mResponseDelay;     // ms
+    char mResponse;
+    bool mValidate;
+    qint64 mByteTime;       // us per byte on the line, 0: not modelled
+    QSet<quint16> mAddresses;
+    QByteArray mPending;    // responses to frames not answered yet
+    quint64 mCntFrames;
+    quint64 mCntRejected;
+    QByteArray mRxFrame;    // frame being received
+    QByteArray mLastFrame;
+    QByteArray mTxBuffer;   // response bytes not read yet
+};
+
+#endif // SIMULATEDDEVICE_H
@@ -0,0 +1,276 @@
+#include "baudsweep.h"
+#include <QDebug>
+#include <QSerialPort>
+#include <fd.h>
+#include <testmanager.h>
+#include <serialprotocol.h>
+#include <simulateddevice.h>
+
+using namespace fd;
+
+BaudSweep::BaudSweep(TestManager *testManager, SerialProtocol *serialProtocol, const QStringList &serialParams,
+                     QObject *parent) :
+    QObject(parent)
+{
+    mTestManager = testManager;
+    mSerialProtocol = serialProtocol;
+    mSerialPort = 0;
+    mSimulatedDevice = 0;
+    mSerialParams = serialParams;
+    mClock = Clock::system();
+    mRates << 9600 << 19200 << 38400 << 57600 << 115200;
+    mIsSeriobus = false;
+    mIsRunning = false;
+    mDuration = 10000;
+    mMaxErrorRate = 0.001;
+    mActive = 0;
+    mEnd = 0;
+    mId = 0;
+    mLength = 0;
+
+    mResponseTimer.setSingleShot(true);
+    mResponseTimer.setInterval(200);
+
+    connect(&mResponseTimer, SIGNAL(timeout()), this, SLOT(onResponseTimeout()));
+    connect(mSerialProtocol, SIGNAL(receivedACK()), this, SLOT(onReceivedACK()));
+    connect(mSerialProtocol, SIGNAL(receivedNACK()), this, SLOT(onReceivedNACK()));
+}
+
+void BaudSweep::setClock(Clock *clock)
+{
+    mClock = clock ? clock : Clock::system();
+    mResponseTimer.setClock(clock);
+}
+
+void BaudSweep::start()
+{
+    mSettings.clear();
+
+    if ((mSerialParams.count() != 4) || mTestManager->testPatterns().isEmpty())
+    {
+        qWarning() << "baud sweep: serial param and test patterns required";
+        emit finished();
+        return;
+    }
+
+    // settings from the slowest and safest (2 stop bits) to the fastest
+    foreach (int rate, mRates)
+    {
+        for (int stopBits = 2; stopBits >= 1; --stopBits)
+        {
+            sSetting setting = sSetting();
+
+            setting.rate = rate;
+            setting.stopBits = stopBits;
+            mSettings.append(setting);
+        }
+    }
+
+    mIsSeriobus = mTestManager->isSeriobus();
+    mIsRunning = true;
+    mActive = -1;
+    mId = 0;
+
+    finish();
+}
+
+void BaudSweep::stop()
+{
+    if (!mIsRunning)
+        return;
+
+    mIsRunning = false;
+    mResponseTimer.stop();
+
+    // keep the best setting
+    if (best() >= 0)
+        configure(mSettings.at(best()));
+
+    report();
+    emit finished();
+}
+
+// reconfigure host and frame time model, return true on errors
+bool BaudSweep::configure(const sSetting &setting)
+{
+    int dataBits = mSerialParams.at(2).toInt();
+    bool isParity = mSerialParams.at(1) != "n";
+
+    if (mSerialPort && (!mSerialPort->setBaudRate(setting.rate) ||
+                        !mSerialPort->setStopBits(setting.stopBits == 1 ? QSerialPort::OneStop : QSerialPort::TwoStop)))
+    {
+        qWarning() << "cannot set" << paramOf(setting) << "on" << mSerialPort->portName();
+        return true;
+    }
+
+    if (mSimulatedDevice)
+        mSimulatedDevice->setLineRate(setting.rate, SerialProtocol::bitsPerByte(dataBits, isParity, setting.stopBits));
+
+    mSerialProtocol->setSerialFormat(setting.rate, dataBits, isParity, setting.stopBits);
+    return false;
+}
+
+// next setting
+void BaudSweep::finish()
+{
+    mResponseTimer.stop();
+
+    if (mActive >= 0)
+    {
+        sSetting &setting = mSettings[mActive];
+        setting.goodput = 1000.0 * setting.bytes / qMax(mDuration, 1);
+
+        qDebug().noquote() << QString("%1: %2 frames, %3 nack, %4 timeout, %5 bytes/s")
+                              .arg(paramOf(setting)).arg(setting.sent).arg(setting.nack).arg(setting.timeout)
+                              .arg(setting.goodput, 0, 'f', 1);
+    }
+
+    while (++mActive < mSettings.count())
+    {
+        if (!configure(mSettings.at(mActive)))
+        {
+            mEnd = mClock->now() + mDuration;
+            sendNext();
+            return;
+        }
+    }
+
+    stop();
+}
+
+void BaudSweep::sendNext()
+{
+    if (!mIsRunning)
+        return;
+
+    if (mClock->now() >= mEnd)
+    {
+        finish();
+        return;
+    }
+
+    const TestPatternGenerator &testPatterns = mTestManager->testPatterns();
+    QByteArray protocol;
+
+    // next pattern with a protocol, at most one cycle
+    for (quint64 i = 0; protocol.isEmpty() && (i < testPatterns.count()); ++i)
+    {
+        mId = mId ? testPatterns.next(mId) : 0;
+
+        if (!mId)
+            mId = testPatterns.first();
+
+        sTestPattern testPattern = testPatterns.at(mId);
+        protocol = mTestManager->encodeLrProtocol(testPattern, TestManager::makeLrProtocolHeader(mTestManager->command()),
+                                                  true);
+    }
+
+    if (protocol.isEmpty())
+    {
+        qWarning() << "baud sweep: no protocol of the test patterns";
+        stop();
+        return;
+    }
+
+    mLength = payloadLength(protocol);
+
+    if (mIsSeriobus)
+        protocol.prepend('W');
+
+    ++mSettings[mActive].sent;
+
+    mSerialProtocol->sendFrame(SerialProtocol::frame(protocol));
+    mResponseTimer.start();
+}
+
+void BaudSweep::onReceivedACK()
+{
+    if (!mIsRunning || !mResponseTimer.isActive())
+        return;
+
+    ++mSettings[mActive].ack;
+    mSettings[mActive].bytes += mLength;
+
+    mResponseTimer.stop();
+    sendNext();
+}
+
+void BaudSweep::onReceivedNACK()
+{
+    if (!mIsRunning || !mResponseTimer.isActive())
+        return;
+
+    ++mSettings[mActive].nack;
+
+    mResponseTimer.stop();
+    sendNext();
+}
+
+void BaudSweep::onResponseTimeout()
+{
+    if (!mIsRunning)
+        return;
+
+    ++mSettings[mActive].timeout;
+    sendNext();
+}
+
+// index of the setting with the highest goodput within the error limit, -1 if none
+int BaudSweep::best() const
+{
+    int best = -1;
+
+    for (int i = 0; i < mSettings.count(); ++i)
+    {
+        const sSetting &setting = mSettings.at(i);
+
+        if (!setting.sent || (double(setting.nack + setting.timeout) / setting.sent > mMaxErrorRate))
+            continue;
+
+        if ((best < 0) || (setting.goodput > mSettings.at(best).goodput))
+            best = i;
+    }
+
+    return best;
+}
+
+// serial param of the setting, e.g. "38400,n,8,2"
+QString BaudSweep::paramOf(const sSetting &setting) const
+{
+    return QString("%1,%2,%3,%4").arg(setting.rate).arg(mSerialParams.value(1)).arg(mSerialParams.value(2))
+            .arg(setting.stopBits);
+}
+
+void BaudSweep::report() const
+{
+    int i = best();
+
+    if (i < 0)
+    {
+        qWarning() << "baud sweep: no setting within error rate" << mMaxErrorRate;
+        return;
+    }
+
+    qDebug().noquote() << QString("fastest reliable setting: %1 (%2 bytes/s)")
+                          .arg(paramOf(mSettings.at(i))).arg(mSettings.at(i).goodput, 0, 'f', 1);
+}
+
+// bytes of the text (0x28, 0x26) or alarm (0x27), without header and checksum
+int BaudSweep::payloadLength(const QByteArray &protocol)
+{
+    if (protocol.length() <= PROT_HDR_CMD)
+        return 0;
+
+    uchar cmd = protocol.at(PROT_HDR_CMD);
+
+    if (cmd == LR_CMD_28)
+        return (protocol.length() > PROT_28_PL_LENGTH) ? (uchar)protocol.at(PROT_28_PL_LENGTH) : 0;
+
+    if (cmd == LR_CMD_26)
+        return qMax(0, protocol.length() - PROT_26_PL_DATA);
+
+    if (cmd == LR_CMD_27)
+        return qMax(0, protocol.length() - PROT_27_ALARM_TYPE);
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+#ifndef BAUDSWEEP_H
+#define BAUDSWEEP_H
+
+#include <QObject>
+#include <QList>
+#include <QStringList>
+#include <clock.h>
+
+class TestManager;
+class SerialProtocol;
+class QSerialPort;
+class SimulatedDevice;
+
+/**
+ * Sweep of the serial settings to find the fastest reliable link setting.
+ *
+ * For each baud rate and number of stop bits, the host port (or the
+ * simulated device) and the frame time model of the serial protocol are
+ * reconfigured, and test patterns are sent back to back for a short time.
+ * The goodput (payload bytes acknowledged per second) and the error rate
+ * (NACK and timeouts per frame) are measured per setting. The setting with
+ * the highest goodput and an error rate within the limit is reported.
+ *
+ * The LR protocols have no command to change the serial settings of the
+ * display, so the display has to follow the sweep by itself (auto baud) or
+ * be set up for the swept settings.
+ */
+class BaudSweep : public QObject
+{
+    Q_OBJECT
+public:
+    struct sSetting {
+        int rate;
+        int stopBits;
+        quint64 sent;
+        quint64 ack;
+        quint64 nack;
+        quint64 timeout;
+        quint64 bytes;          // payload bytes acknowledged
+        double goodput;         // bytes per second
+    };
+
+    BaudSweep(TestManager *testManager, SerialProtocol *serialProtocol, const QStringList &serialParams,
+              QObject *parent = 0);
+
+    void setClock(Clock *clock);
+    void setSerialPort(QSerialPort *serialPort) { mSerialPort = serialPort; }
+    void setSimulatedDevice(SimulatedDevice *device) { mSimulatedDevice = device; }
+    void setRates(const QList<int> &rates) { mRates = rates; }
+    void setDuration(int msec) { mDuration = msec; }
+    void setMaxErrorRate(double rate) { mMaxErrorRate = rate; }
+    void setResponseTimeout(int msec) { mResponseTimer.setInterval(msec); }
+
+    const QList<sSetting> &settings() const { return mSettings; }
+    int best() const;
+    QString paramOf(const sSetting &setting) const;
+    void report() const;
+
+signals:
+    void finished();
+
+public slots:
+    void start();
+    void stop();
+
+private slots:
+    void onReceivedACK();
+    void onReceivedNACK();
+    void onResponseTimeout();
+
+private:
+    TestManager *mTestManager;
+    SerialProtocol *mSerialProtocol;
+    QSerialPort *mSerialPort;
+    SimulatedDevice *mSimulatedDevice;
+    QStringList mSerialParams;  // "<rate>", "<parity>", "<data bits>", "<stop bits>" of the setup
+    Clock *mClock;
+    ClockTimer mResponseTimer;
+    QList<int> mRates;
+    QList<sSetting> mSettings;
+    bool mIsSeriobus;
+    bool mIsRunning;
+    int mDuration;              // ms per setting
+    double mMaxErrorRate;
+    int mActive;                // index of the running setting
+    qint64 mEnd;                // end of the running setting
+    quint64 mId;                // pattern sent last
+    int mLength;                // payload length of the frame waiting for response
+
+    bool configure(const sSetting &setting);
+    void sendNext();
+    void finish();
+
+    static int payloadLength(const QByteArray &protocol);
+};
+
+#endif // BAUDSWEEP_H
@@ -0,0 +1,370 @@
+#include "busscheduler.h"
+#include <QDebug>
+#include <fd.h>
+#include <serialprotocol.h>
+
+using namespace fd;
+
+BusScheduler::BusScheduler(SerialProtocol *serialProtocol, QObject *parent) :
+    QObject(parent)
+{
+    mSerialProtocol = serialProtocol;
+    mClock = Clock::system();
+    mPolicy = PolicyRoundRobin;
+    mRefresh = true;
+    mIsSeriobus = false;
+    mIsRunning = false;
+    mSeq = 0;
+    mNext = 0;
+    mActive = -1;
+    mActiveGroup = -1;
+
+    mResponseTimer.setSingleShot(true);
+    mResponseTimer.setInterval(100);
+
+    connect(&mResponseTimer, SIGNAL(timeout()), this, SLOT(onResponseTimeout()));
+    connect(mSerialProtocol, SIGNAL(receivedACK()), this, SLOT(onReceivedACK()));
+    connect(mSerialProtocol, SIGNAL(receivedNACK()), this, SLOT(onReceivedNACK()));
+}
+
+void BusScheduler::setClock(Clock *clock)
+{
+    mClock = clock ? clock : Clock::system();
+    mResponseTimer.setClock(clock);
+}
+
+void BusScheduler::setDisplays(const QVector<quint16> &displays)
+{
+    sDisplayState state = sDisplayState();
+
+    state.lastAck = -1;
+
+    mDisplays = displays;
+    mEntries.clear();
+    mStates.clear();
+    mGroups.clear();
+    mGroupOf.clear();
+    mGroupStates.clear();
+    mNext = 0;
+    mActive = -1;
+    mActiveGroup = -1;
+
+    foreach (quint16 addr, mDisplays)
+        mStates.insert(addr, state);
+}
+
+// return true on errors, a display is member of one group at most
+bool BusScheduler::addGroup(quint16 group, const QVector<quint16> &members)
+{
+    sDisplayState state = sDisplayState();
+
+    state.lastAck = -1;
+
+    if (!group || members.isEmpty() || mGroups.contains(group))
+        return true;
+
+    if ((group >> 8) && (mCommands.contains(LR_CMD_26) || mCommands.contains(LR_CMD_27)))
+    {
+        qWarning() << "group" << addrToString(group) << ": protocols 0x26 and 0x27 address room groups of station 0 only";
+        return true;
+    }
+
+    foreach (quint16 addr, members)
+    {
+        if (!mStates.contains(addr) || mGroupOf.contains(addr))
+        {
+            qWarning() << "display" << addrToString(addr) << "cannot join group" << addrToString(group);
+            return true;
+        }
+    }
+
+    foreach (quint16 addr, members)
+        mGroupOf.insert(addr, group);
+
+    mGroups.insert(group, members);
+    mGroupStates.insert(group, state);
+
+    return false;
+}
+
+bool BusScheduler::isOnline(quint16 addr) const
+{
+    int group = groupOf(addr);
+
+    if (mStates.value(addr).cntMissed >= MAX_MISSED)
+        return false;
+
+    return (group < 0) || (mGroupStates.value(group).cntMissed < MAX_MISSED);
+}
+
+BusScheduler::Policy BusScheduler::policyFromString(const QString &policy)
+{
+    return (policy == "priority") ? PolicyPriority : PolicyRoundRobin;
+}
+
+// latest protocol of the display, replaces a protocol not sent yet
+void BusScheduler::enqueue(quint16 addr, const QByteArray &protocol, int prio)
+{
+    if (!mStates.contains(addr) || (protocol.length() <= PROT_HDR_CMD))
+        return;
+
+    sEntry entry;
+
+    entry.protocol = protocol;
+    entry.content = contentOf(protocol);
+    entry.prio = prio;
+    entry.seq = mSeq++;
+    entry.isPending = true;
+
+    mEntries.insert(addr, entry);
+
+    if (mIsRunning && (mActive < 0))
+        sendNext();
+}
+
+void BusScheduler::start()
+{
+    mIsRunning = true;
+
+    if (mActive < 0)
+        sendNext();
+}
+
+void BusScheduler::stop()
+{
+    mIsRunning = false;
+    mResponseTimer.stop();
+    mActive = -1;
+    mActiveGroup = -1;
+}
+
+// index of the display to be served next, -1 if nothing to send
+int BusScheduler::pick()
+{
+    int best = -1;
+
+    for (int k = 0; k < mDisplays.count(); ++k)
+    {
+        int i = (mNext + k) % mDisplays.count();
+        QHash<quint16, sEntry>::ConstIterator entry = mEntries.constFind(mDisplays.at(i));
+
+        if ((entry == mEntries.constEnd()) || !entry.value().isPending)
+            continue;
+
+        if (mPolicy == PolicyRoundRobin)
+            return i;
+
+        const sEntry &other = mEntries[mDisplays.at(best < 0 ? i : best)];
+
+        if ((best < 0) || (entry.value().prio > other.prio) ||
+                ((entry.value().prio == other.prio) && (entry.value().seq < other.seq)))
+        {
+            best = i;
+        }
+    }
+
+    if ((best < 0) && mRefresh)     // nothing new, repeat protocols round robin
+    {
+        for (int k = 0; k < mDisplays.count(); ++k)
+        {
+            int i = (mNext + k) % mDisplays.count();
+
+            if (mEntries.contains(mDisplays.at(i)))
+                return i;
+        }
+    }
+
+    return best;
+}
+
+// group of the display, if all its members have the same content in the same state, -1 otherwise
+int BusScheduler::groupFor(quint16 addr) const
+{
+    int group = groupOf(addr);
+
+    if (group < 0)
+        return -1;
+
+    const sEntry &entry = mEntries[addr];
+
+    foreach (quint16 member, mGroups[group])
+    {
+        QHash<quint16, sEntry>::ConstIterator other = mEntries.constFind(member);
+
+        if ((other == mEntries.constEnd()) || (other.value().isPending != entry.isPending) ||
+                (other.value().content != entry.content))
+        {
+            return -1;
+        }
+    }
+
+    return group;
+}
+
+void BusScheduler::sendNext()
+{
+    if (!mIsRunning)
+        return;
+
+    mActive = pick();
+
+    if (mActive < 0)
+        return;
+
+    quint16 addr = mDisplays.at(mActive);
+    QByteArray protocol = mEntries[addr].protocol;
+
+    mActiveGroup = groupFor(addr);
+    mNext = (mActive + 1) % mDisplays.count();
+
+    if (mActiveGroup < 0)
+    {
+        mEntries[addr].isPending = false;
+        ++mStates[addr].sent;
+    }
+    else
+    {
+        foreach (quint16 member, mGroups[mActiveGroup])
+            mEntries[member].isPending = false;
+
+        ++mGroupStates[mActiveGroup].sent;
+        protocol = groupProtocol(protocol, mActiveGroup);
+    }
+
+    if (mIsSeriobus)
+        protocol.prepend('W');
+
+    mSerialProtocol->sendFrame(SerialProtocol::frame(protocol));
+    mResponseTimer.start();
+}
+
+void BusScheduler::finish(bool isAck)
+{
+    quint16 addr = (mActiveGroup < 0) ? mDisplays.at(mActive) : mActiveGroup;
+    sDisplayState &state = (mActiveGroup < 0) ? mStates[addr] : mGroupStates[addr];
+
+    mResponseTimer.stop();
+
+    if (isAck)
+    {
+        ++state.ack;
+        state.lastAck = mClock->now();
+        state.cntMissed = 0;
+
+        if (mActiveGroup < 0)
+            emit acknowledged(addr);
+        else
+            emit groupAcknowledged(addr);
+    }
+    else
+    {
+        ++state.nack;
+    }
+
+    mActive = -1;
+    mActiveGroup = -1;
+    sendNext();
+}
+
+void BusScheduler::onReceivedACK()
+{
+    if (mActive >= 0)
+        finish(true);
+}
+
+void BusScheduler::onReceivedNACK()
+{
+    if (mActive >= 0)
+        finish(false);
+}
+
+void BusScheduler::onResponseTimeout()
+{
+    if (mActive < 0)
+        return;
+
+    quint16 addr = (mActiveGroup < 0) ? mDisplays.at(mActive) : mActiveGroup;
+    sDisplayState &state = (mActiveGroup < 0) ? mStates[addr] : mGroupStates[addr];
+
+    ++state.timeout;
+    ++state.cntMissed;
+
+    if (state.cntMissed == MAX_MISSED)
+        qWarning() << ((mActiveGroup < 0) ? "display" : "group") << addrToString(addr) << "is offline";
+
+    if (mActiveGroup < 0)
+        emit missed(addr);
+    else
+        emit groupMissed(addr);
+
+    mActive = -1;
+    mActiveGroup = -1;
+    sendNext();
+}
+
+// protocol without destination address, equal for the members of a group with the same content
+QByteArray BusScheduler::contentOf(const QByteArray &protocol)
+{
+    QByteArray content = protocol;
+
+    if (((uchar)content.at(PROT_HDR_CMD) == LR_CMD_28) && (content.length() > PROT_28_RM_GRP))
+    {
+        content[PROT_28_DST_ST] = 0;
+        content[PROT_28_DST_RM] = 0;
+        content[PROT_28_ST_GRP] = 0;
+        content[PROT_28_RM_GRP] = 0;
+    }
+    else if (content.length() > PROT_26_GRP)
+    {
+        content[PROT_26_GRP] = 0;
+    }
+
+    return content;
+}
+
+// protocol addressed to all members of the group
+QByteArray BusScheduler::groupProtocol(const QByteArray &protocol, quint16 group)
+{
+    QByteArray groupProtocol = protocol;
+
+    if (((uchar)groupProtocol.at(PROT_HDR_CMD) == LR_CMD_28) && (groupProtocol.length() > PROT_28_RM_GRP))
+    {
+        groupProtocol[PROT_28_DST_ST] = 0;
+        groupProtocol[PROT_28_DST_RM] = 0;
+        groupProtocol[PROT_28_ST_GRP] = group >> 8;
+        groupProtocol[PROT_28_RM_GRP] = group & 0xFF;
+    }
+    else if (groupProtocol.length() > PROT_26_GRP)  // 0x26, 0x27: group number only
+    {
+        groupProtocol[PROT_26_GRP] = group & 0xFF;
+    }
+
+    return groupProtocol;
+}
+
+QString BusScheduler::addrToString(quint16 addr)
+{
+    return QString("%1.%2").arg(addr >> 8).arg(addr & 0xFF);
+}
+
+void BusScheduler::report() const
+{
+    foreach (quint16 addr, mDisplays)
+    {
+        const sDisplayState &state = mStates[addr];
+
+        qDebug().noquote() << QString("%1: %2 sent, %3 ack, %4 nack, %5 timeout%6")
+                              .arg(addrToString(addr))
+                              .arg(state.sent).arg(state.ack).arg(state.nack).arg(state.timeout)
+                              .arg(isOnline(addr) ? "" : ", offline");
+    }
+
+    for (QHash<quint16, QVector<quint16> >::ConstIterator itr = mGroups.constBegin(); itr != mGroups.constEnd(); ++itr)
+    {
+        const sDisplayState &state = mGroupStates[itr.key()];
+
+        qDebug().noquote() << QString("group %1 (%2 displays): %3 sent, %4 ack, %5 nack, %6 timeout")
+                              .arg(addrToString(itr.key())).arg(itr.value().count())
+                              .arg(state.sent).arg(state.ack).arg(state.nack).arg(state.timeout);
+    }
+}
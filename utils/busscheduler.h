@@ -0,0 +1,124 @@
+#ifndef BUSSCHEDULER_H
+#define BUSSCHEDULER_H
+
+#include <QObject>
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QByteArray>
+#include <clock.h>
+
+class SerialProtocol;
+
+/**
+ * Scheduler of the frames to the displays of a RS485 segment.
+ *
+ * Each display (LR-address) keeps its latest protocol. Frames are sent one
+ * at a time, the next one as soon as the addressed display answered or its
+ * response timed out, so that the line is kept busy. Displays are served
+ * round robin or by priority of their protocols (oldest first on equal
+ * priority). Without new protocols, the protocols of the displays are
+ * repeated round robin (refresh). The ACK state is tracked per address.
+ *
+ * Displays can be members of groups (station group << 8 | room group). If
+ * all members of a group have the same content, a single frame is sent to
+ * the group instead of one frame per member, and its ACK is tracked per
+ * group.
+ * The protocols 0x26 and 0x27 have a group number only, so with these
+ * commands a group is a room group of station 0 (e.g. 0.5).
+ */
+class BusScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum Policy {
+        PolicyRoundRobin,
+        PolicyPriority
+    };
+
+    struct sDisplayState {
+        quint64 sent;
+        quint64 ack;
+        quint64 nack;
+        quint64 timeout;
+        qint64 lastAck;     // time of the last ACK, -1 if none
+        int cntMissed;      // consecutive responses missed
+    };
+
+    explicit BusScheduler(SerialProtocol *serialProtocol, QObject *parent = 0);
+
+    void setClock(Clock *clock);
+    void setPolicy(Policy policy) { mPolicy = policy; }
+    void setResponseTimeout(int msec) { mResponseTimer.setInterval(msec); }
+    void setRefresh(bool refresh) { mRefresh = refresh; }
+    void setSeriobus(bool isSeriobus) { mIsSeriobus = isSeriobus; }
+    void setCommands(const QList<uchar> &commands) { mCommands = commands; }
+    void setDisplays(const QVector<quint16> &displays);
+    bool addGroup(quint16 group, const QVector<quint16> &members);
+
+    const QVector<quint16> &displays() const { return mDisplays; }
+    int groupOf(quint16 addr) const { return mGroupOf.value(addr, -1); }
+    sDisplayState state(quint16 addr) const { return mStates.value(addr); }
+    sDisplayState groupState(quint16 group) const { return mGroupStates.value(group); }
+    bool isOnline(quint16 addr) const;
+    void report() const;
+
+    static Policy policyFromString(const QString &policy);
+
+signals:
+    void acknowledged(quint16 addr);
+    void missed(quint16 addr);
+    void groupAcknowledged(quint16 group);
+    void groupMissed(quint16 group);
+
+public slots:
+    void enqueue(quint16 addr, const QByteArray &protocol, int prio);
+    void start();
+    void stop();
+
+private slots:
+    void onReceivedACK();
+    void onReceivedNACK();
+    void onResponseTimeout();
+
+private:
+    static const int MAX_MISSED = 3;
+
+    struct sEntry {
+        QByteArray protocol;
+        QByteArray content;     // protocol without destination address
+        int prio;
+        quint64 seq;            // order of enqueue
+        bool isPending;         // not sent since enqueued
+    };
+
+    SerialProtocol *mSerialProtocol;
+    Clock *mClock;
+    ClockTimer mResponseTimer;
+    Policy mPolicy;
+    bool mRefresh;
+    bool mIsSeriobus;
+    bool mIsRunning;
+    QList<uchar> mCommands;     // commands of the protocols, limit the groups
+    QVector<quint16> mDisplays;
+    QHash<quint16, sEntry> mEntries;
+    QHash<quint16, sDisplayState> mStates;
+    QHash<quint16, QVector<quint16> > mGroups;  // members per group
+    QHash<quint16, int> mGroupOf;               // group per member
+    QHash<quint16, sDisplayState> mGroupStates;
+    quint64 mSeq;
+    int mNext;              // round robin position in mDisplays
+    int mActive;            // address index of the frame waiting for response, -1 if none
+    int mActiveGroup;       // group of the frame waiting for response, -1 if unicast
+
+    int pick();
+    int groupFor(quint16 addr) const;
+    void sendNext();
+    void finish(bool isAck);
+
+    static QByteArray contentOf(const QByteArray &protocol);
+    static QByteArray groupProtocol(const QByteArray &protocol, quint16 group);
+    static QString addrToString(quint16 addr);
+};
+
+#endif // BUSSCHEDULER_H
@@ -0,0 +1,124 @@
+#include "bustest.h"
+#include <QDebug>
+#include <fd.h>
+#include <testmanager.h>
+#include <busscheduler.h>
+
+using namespace fd;
+
+BusTest::BusTest(TestManager *testManager, BusScheduler *scheduler, QObject *parent) :
+    QObject(parent)
+{
+    mTestManager = testManager;
+    mScheduler = scheduler;
+    mScheduler->setCommands(QList<uchar>() << LR_CMD_28);    // the bus test sends 0x28 only
+    mClock = Clock::system();
+    mIsRunning = false;
+    mEnd = 0;
+    mCntQueued = 0;
+
+    mPeriodTimer.setInterval(PERIOD_TEXT);
+
+    connect(&mPeriodTimer, SIGNAL(timeout()), this, SLOT(onPeriodTimeout()));
+}
+
+void BusTest::setClock(Clock *clock)
+{
+    mClock = clock ? clock : Clock::system();
+    mPeriodTimer.setClock(clock);
+    mScheduler->setClock(clock);
+}
+
+void BusTest::start(qint64 duration)
+{
+    const TestPatternGenerator &testPatterns = mTestManager->testPatterns();
+    int cntDisplays = mScheduler->displays().count();
+
+    if (!mTestManager->commands().contains(LR_CMD_28) || testPatterns.isEmpty() || !cntDisplays)
+    {
+        qWarning() << "bus test: protocol 0x28, test patterns and displays required";
+        emit finished();
+        return;
+    }
+
+    mIsRunning = true;
+    mScheduler->setSeriobus(mTestManager->isSeriobus());
+    mEnd = mClock->now() + duration;
+    mCntQueued = 0;
+    mIds.fill(0, cntDisplays);
+
+    // stagger the patterns of the displays, members of a group show the same pattern
+    QHash<int, quint64> groupIds;
+    quint64 id = testPatterns.first();
+
+    for (int i = 0; i < cntDisplays; ++i)
+    {
+        int group = mScheduler->groupOf(mScheduler->displays().at(i));
+
+        if (groupIds.contains(group))
+        {
+            mIds[i] = groupIds.value(group);
+            continue;
+        }
+
+        if (group >= 0)
+            groupIds.insert(group, id);
+
+        mIds[i] = id;
+        id = testPatterns.next(id);
+
+        if (!id)
+            id = testPatterns.first();
+    }
+
+    onPeriodTimeout();
+    mPeriodTimer.start();
+    mScheduler->start();
+}
+
+void BusTest::stop()
+{
+    if (!mIsRunning)
+        return;
+
+    mIsRunning = false;
+    mPeriodTimer.stop();
+    mScheduler->stop();
+
+    qDebug() << "bus test:" << mCntQueued << "frames queued to" << mScheduler->displays().count() << "displays";
+    mScheduler->report();
+
+    emit finished();
+}
+
+void BusTest::onPeriodTimeout()
+{
+    if (mClock->now() >= mEnd)
+    {
+        stop();
+        return;
+    }
+
+    const TestPatternGenerator &testPatterns = mTestManager->testPatterns();
+    const QVector<quint16> &displays = mScheduler->displays();
+    QByteArray header = TestManager::makeLrProtocolHeader(LR_CMD_28);
+
+    for (int i = 0; i < displays.count(); ++i)
+    {
+        sTestPattern testPattern = testPatterns.at(mIds.at(i));
+
+        testPattern.dstSt = displays.at(i) >> 8;
+        testPattern.dstRm = displays.at(i) & 0xFF;
+
+        QByteArray protocol = mTestManager->encodeLrProtocol(testPattern, header, true);
+
+        quint64 next = testPatterns.next(mIds.at(i));
+        mIds[i] = next ? next : testPatterns.first();
+
+        if (protocol.isEmpty())
+            continue;
+
+        mScheduler->enqueue(displays.at(i), protocol, testPattern.prio);
+        ++mCntQueued;
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef BUSTEST_H
+#define BUSTEST_H
+
+#include <QObject>
+#include <QVector>
+#include <clock.h>
+
+class TestManager;
+class BusScheduler;
+
+/**
+ * Test of the displays of a RS485 segment.
+ *
+ * Each display is addressed individually (protocol 0x28) and shows the test
+ * patterns in turn, starting at a pattern staggered by its position on the
+ * segment; the members of a group show the same patterns. Per period, the
+ * next pattern of each display is passed to the bus scheduler, which sends
+ * the frames interleaved (one frame per group of equal content) and tracks
+ * the ACK state of the displays and groups.
+ */
+class BusTest : public QObject
+{
+    Q_OBJECT
+public:
+    BusTest(TestManager *testManager, BusScheduler *scheduler, QObject *parent = 0);
+
+    void setClock(Clock *clock);
+    void setPeriod(int msec) { mPeriodTimer.setInterval(msec); }
+
+    bool isRunning() const { return mIsRunning; }
+    quint64 framesQueued() const { return mCntQueued; }
+
+signals:
+    void finished();
+
+public slots:
+    void start(qint64 duration);
+    void stop();
+
+private slots:
+    void onPeriodTimeout();
+
+private:
+    TestManager *mTestManager;
+    BusScheduler *mScheduler;
+    Clock *mClock;
+    ClockTimer mPeriodTimer;
+    bool mIsRunning;
+    qint64 mEnd;                // end of the test
+    QVector<quint64> mIds;      // pattern shown per display
+    quint64 mCntQueued;
+};
+
+#endif // BUSTEST_H
@@ -0,0 +1,217 @@
+#include "checkpointjournal.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QtEndian>
+
+static const quint32 CHECKPOINT_MAGIC = 0x4B434446;     // "FDCK"
+static const quint32 CHECKPOINT_VERSION = 1;
+
+CheckpointJournal::CheckpointJournal()
+{
+    mCntFrames = 0;
+}
+
+QString CheckpointJournal::defaultFile()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("checkpoint.fdc");
+}
+
+// start a new journal, return true on errors
+bool CheckpointJournal::create(const QString &fileName, quint32 fingerprint)
+{
+    uchar header[HEADER_SIZE];
+
+    remove();
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    mFile.setFileName(fileName);
+
+    if (!mFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "cannot create checkpoint" << fileName;
+        return true;
+    }
+
+    qToLittleEndian<quint32>(CHECKPOINT_MAGIC, header);
+    qToLittleEndian<quint32>(CHECKPOINT_VERSION, header + 4);
+    qToLittleEndian<quint32>(fingerprint, header + 8);
+
+    if ((mFile.write((const char *)header, HEADER_SIZE) != HEADER_SIZE) || !mFile.flush())
+    {
+        remove();
+        return true;
+    }
+
+    mCntFrames = 0;
+    return false;
+}
+
+// replay the journal of the same test cycle and continue it, return true if there is nothing to resume
+bool CheckpointJournal::open(const QString &fileName, quint32 fingerprint, sState &state, QVector<sFrameMetric> &frames)
+{
+    uchar header[HEADER_SIZE];
+    bool isState = false;
+
+    remove();
+    mFile.setFileName(fileName);
+    frames.clear();
+
+    if (!mFile.exists() || !mFile.open(QIODevice::ReadWrite))
+        return true;
+
+    if ((mFile.read((char *)header, HEADER_SIZE) != HEADER_SIZE) ||
+            (qFromLittleEndian<quint32>(header) != CHECKPOINT_MAGIC) ||
+            (qFromLittleEndian<quint32>(header + 4) != CHECKPOINT_VERSION) ||
+            (qFromLittleEndian<quint32>(header + 8) != fingerprint))
+    {
+        qDebug() << "checkpoint does not match the test:" << fileName;
+        mFile.close();
+        return true;
+    }
+
+    qint64 valid = HEADER_SIZE;
+
+    forever
+    {
+        uchar head[5];
+        uchar sum[2];
+
+        if (mFile.read((char *)head, 5) != 5)
+            break;
+
+        quint32 length = qFromLittleEndian<quint32>(head + 1);
+
+        if (length > mFile.size() - mFile.pos())
+            break;
+
+        QByteArray record = QByteArray((const char *)head, 5) + mFile.read(length);
+
+        if ((mFile.read((char *)sum, 2) != 2) ||
+                (qFromLittleEndian<quint16>(sum) != qChecksum(record.constData(), record.length())))
+        {
+            break;
+        }
+
+        const uchar *payload = (const uchar *)record.constData() + 5;
+
+        if ((head[0] == RecordState) && (length == STATE_SIZE))
+        {
+            state.id = qFromLittleEndian<quint64>(payload);
+            state.cmd = payload[8];
+            state.start = qFromLittleEndian<qint64>(payload + 9);
+            state.elapsed = qFromLittleEndian<qint64>(payload + 17);
+            state.sent = qFromLittleEndian<quint64>(payload + 25);
+            state.ack = qFromLittleEndian<quint64>(payload + 33);
+            state.nack = qFromLittleEndian<quint64>(payload + 41);
+            isState = true;
+        }
+        else if (head[0] == RecordFrames)
+        {
+            for (quint32 i = 0; i + FRAME_SIZE <= length; i += FRAME_SIZE)
+            {
+                sFrameMetric frame;
+
+                frame.time = qFromLittleEndian<qint32>(payload + i);
+                frame.cmd = payload[i + 4];
+                frame.response = payload[i + 5];
+                frame.length = qFromLittleEndian<quint16>(payload + i + 6);
+                frame.latency = qFromLittleEndian<qint32>(payload + i + 8);
+                frames.append(frame);
+            }
+        }
+
+        valid = mFile.pos();
+    }
+
+    if (!isState)
+    {
+        remove();
+        return true;
+    }
+
+    // drop the incomplete tail, append after the last valid record
+    mFile.resize(valid);
+    mFile.seek(valid);
+    mCntFrames = frames.count();
+
+    qDebug() << "checkpoint" << fileName << ": pattern" << state.id << "," << state.elapsed / 1000 << "s," << frames.count() << "frames";
+    return false;
+}
+
+// close and delete the journal, e.g. on regular end of the test
+void CheckpointJournal::remove()
+{
+    if (mFile.isOpen())
+    {
+        mFile.close();
+        mFile.remove();
+    }
+
+    mCntFrames = 0;
+}
+
+// append the frames not yet written and the state, return true on errors
+bool CheckpointJournal::append(const sState &state, const QVector<sFrameMetric> &frames)
+{
+    if (!isOpen())
+        return true;
+
+    if (frames.count() < mCntFrames)    // frames of another run
+        mCntFrames = 0;
+
+    if (frames.count() > mCntFrames)
+    {
+        QByteArray payload((frames.count() - mCntFrames) * FRAME_SIZE, 0);
+        uchar *data = (uchar *)payload.data();
+
+        for (int i = mCntFrames; i < frames.count(); ++i, data += FRAME_SIZE)
+        {
+            const sFrameMetric &frame = frames.at(i);
+
+            qToLittleEndian<qint32>(frame.time, data);
+            data[4] = frame.cmd;
+            data[5] = frame.response;
+            qToLittleEndian<quint16>(frame.length, data + 6);
+            qToLittleEndian<qint32>(frame.latency, data + 8);
+        }
+
+        if (appendRecord(RecordFrames, payload))
+            return true;
+
+        mCntFrames = frames.count();
+    }
+
+    QByteArray payload(STATE_SIZE, 0);
+    uchar *data = (uchar *)payload.data();
+
+    qToLittleEndian<quint64>(state.id, data);
+    data[8] = state.cmd;
+    qToLittleEndian<qint64>(state.start, data + 9);
+    qToLittleEndian<qint64>(state.elapsed, data + 17);
+    qToLittleEndian<quint64>(state.sent, data + 25);
+    qToLittleEndian<quint64>(state.ack, data + 33);
+    qToLittleEndian<quint64>(state.nack, data + 41);
+
+    return appendRecord(RecordState, payload) || !mFile.flush();
+}
+
+// return true on errors
+bool CheckpointJournal::appendRecord(uchar type, const QByteArray &payload)
+{
+    QByteArray record(5, 0);
+    uchar sum[2];
+
+    record[0] = type;
+    qToLittleEndian<quint32>(payload.length(), (uchar *)record.data() + 1);
+    record.append(payload);
+    qToLittleEndian<quint16>(qChecksum(record.constData(), record.length()), sum);
+
+    if ((mFile.write(record) != record.length()) || (mFile.write((const char *)sum, 2) != 2))
+    {
+        qWarning() << "cannot write checkpoint" << mFile.fileName();
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,61 @@
+#ifndef CHECKPOINTJOURNAL_H
+#define CHECKPOINTJOURNAL_H
+
+#include <QFile>
+#include <QVector>
+#include <resultsstore.h>
+
+/**
+ * Checkpoints of a running test, to resume it after a crash or a lost adapter.
+ *
+ * The journal is appended only (little endian):
+ *  - header: magic, version, fingerprint of the test cycle
+ *  - record: type (8 bits), payload length (32 bits), payload, checksum (16 bits)
+ *  - state record: pattern id (64 bits), command (8 bits), start of the run
+ *    (ms since epoch, 64 bits), elapsed ms (64 bits), sent, ack, nack (64 bits each)
+ *  - frames record: frame metrics since the previous checkpoint
+ *
+ * On open, the records are replayed (last state, all frames). A record not
+ * completed at the crash fails its checksum and is dropped with the tail.
+ */
+class CheckpointJournal
+{
+public:
+    struct sState {
+        quint64 id;         // test pattern shown last
+        uchar cmd;
+        qint64 start;       // ms since epoch
+        qint64 elapsed;     // ms
+        quint64 sent;
+        quint64 ack;
+        quint64 nack;
+    };
+
+    CheckpointJournal();
+
+    bool create(const QString &fileName, quint32 fingerprint);
+    bool open(const QString &fileName, quint32 fingerprint, sState &state, QVector<sFrameMetric> &frames);
+    void remove();
+    bool isOpen() const { return mFile.isOpen(); }
+
+    bool append(const sState &state, const QVector<sFrameMetric> &frames);
+
+    static QString defaultFile();
+
+private:
+    enum RecordType {
+        RecordState = 1,
+        RecordFrames = 2
+    };
+
+    QFile mFile;
+    int mCntFrames;     // frames written to the journal
+
+    bool appendRecord(uchar type, const QByteArray &payload);
+
+    static const int HEADER_SIZE = 4 + 4 + 4;
+    static const int STATE_SIZE = 8 + 1 + 8 + 8 + 8 + 8 + 8;
+    static const int FRAME_SIZE = 4 + 1 + 1 + 2 + 4;
+};
+
+#endif // CHECKPOINTJOURNAL_H
@@ -0,0 +1,119 @@
+#include "clock.h"
+
+Clock *Clock::system()
+{
+    static SystemClock clock;
+    return &clock;
+}
+
+VirtualClock::VirtualClock()
+{
+    mNow = 0;
+    mSeq = 0;
+}
+
+void VirtualClock::schedule(ClockTimer *timer, qint64 due)
+{
+    cancel(timer);
+
+    timer->mKey = qMakePair(due, mSeq++);
+    mQueue.insert(timer->mKey, timer);
+}
+
+void VirtualClock::cancel(ClockTimer *timer)
+{
+    if (timer->mKey.first >= 0)
+        mQueue.remove(timer->mKey);
+
+    timer->mKey = qMakePair(qint64(-1), quint64(0));
+}
+
+bool VirtualClock::step()
+{
+    if (mQueue.isEmpty())
+        return false;
+
+    ClockTimer *timer = mQueue.begin().value();
+
+    mNow = qMax(mNow, mQueue.begin().key().first);
+
+    // periodic timer is rescheduled before its handler, which may stop or restart it
+    if (timer->mSingleShot)
+        cancel(timer);
+    else
+        schedule(timer, mNow + qMax(timer->mInterval, 1));
+
+    timer->fire();
+    return true;
+}
+
+void VirtualClock::runUntil(qint64 time)
+{
+    while (!mQueue.isEmpty() && (mQueue.begin().key().first <= time))
+        step();
+
+    if (time > mNow)
+        mNow = time;
+}
+
+ClockTimer::ClockTimer(QObject *parent) :
+    QObject(parent)
+{
+    mClock = Clock::system();
+    mInterval = 0;
+    mSingleShot = false;
+    mKey = qMakePair(qint64(-1), quint64(0));
+
+    connect(&mTimer, SIGNAL(timeout()), this, SLOT(fire()));
+}
+
+ClockTimer::~ClockTimer()
+{
+    stop();
+}
+
+void ClockTimer::setClock(Clock *clock)
+{
+    stop();
+    mClock = clock ? clock : Clock::system();
+}
+
+bool ClockTimer::isActive() const
+{
+    if (mClock->isVirtual())
+        return mKey.first >= 0;
+
+    return mTimer.isActive();
+}
+
+void ClockTimer::start()
+{
+    if (mClock->isVirtual())
+    {
+        static_cast<VirtualClock *>(mClock)->schedule(this, mClock->now() + mInterval);
+    }
+    else
+    {
+        mTimer.setSingleShot(mSingleShot);
+        mTimer.start(mInterval);
+    }
+}
+
+void ClockTimer::start(int msec)
+{
+    mInterval = msec;
+    start();
+}
+
+void ClockTimer::stop()
+{
+    if (mClock->isVirtual())
+        static_cast<VirtualClock *>(mClock)->cancel(this);
+    else
+        mTimer.stop();
+}
+
+void ClockTimer::fire()
+{
+    emit timeout();
+}
@@ -0,0 +1,105 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QPair>
+
+class ClockTimer;
+
+/**
+ * Time base of the test manager and the serial protocol, in milliseconds.
+ *
+ * The system clock follows wall-clock time. The virtual clock only advances
+ * when it is run, firing its timers in order of their deadlines, so that
+ * long test cycles are executed deterministically as fast as possible.
+ */
+class Clock
+{
+public:
+    virtual ~Clock() {}
+
+    virtual qint64 now() const = 0;
+    virtual bool isVirtual() const { return false; }
+
+    static Clock *system();
+};
+
+class SystemClock : public Clock
+{
+public:
+    SystemClock() { mElapsed.start(); }
+
+    qint64 now() const { return mElapsed.elapsed(); }
+
+private:
+    QElapsedTimer mElapsed;
+};
+
+class VirtualClock : public Clock
+{
+public:
+    VirtualClock();
+
+    qint64 now() const { return mNow; }
+    bool isVirtual() const { return true; }
+
+    bool step();                    // fire the next timer, false if no timer is active
+    void runUntil(qint64 time);     // fire all timers due up to time
+    void runFor(qint64 duration) { runUntil(mNow + duration); }
+    bool isIdle() const { return mQueue.isEmpty(); }
+
+private:
+    friend class ClockTimer;
+
+    qint64 mNow;
+    quint64 mSeq;                   // order of timers with equal deadline
+    QMap<QPair<qint64, quint64>, ClockTimer *> mQueue;
+
+    void schedule(ClockTimer *timer, qint64 due);
+    void cancel(ClockTimer *timer);
+};
+
+/**
+ * Timer with the interface of QTimer, running on a clock.
+ */
+class ClockTimer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ClockTimer(QObject *parent = 0);
+    ~ClockTimer();
+
+    void setClock(Clock *clock);
+    Clock *clock() const { return mClock; }
+
+    void setInterval(int msec) { mInterval = msec; }
+    int interval() const { return mInterval; }
+    void setSingleShot(bool singleShot) { mSingleShot = singleShot; }
+    bool isSingleShot() const { return mSingleShot; }
+    bool isActive() const;
+
+public slots:
+    void start();
+    void start(int msec);
+    void stop();
+
+signals:
+    void timeout();
+
+private slots:
+    void fire();
+
+private:
+    friend class VirtualClock;
+
+    Clock *mClock;
+    QTimer mTimer;          // used on the system clock
+    int mInterval;
+    bool mSingleShot;
+    QPair<qint64, quint64> mKey;    // deadline on the virtual clock, (-1, 0) if inactive
+};
+
+#endif // CLOCK_H
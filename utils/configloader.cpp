@@ -0,0 +1,159 @@
+#include "configloader.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QtConcurrent>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+#include <QCborValue>
+#include <QCborMap>
+#endif
+#include <fd.h>
+
+using namespace fd;
+
+static const quint32 CACHE_MAGIC = 0x46444343;  // "FDCC"
+static const quint32 CACHE_VERSION = 1;
+
+// load in a worker thread, result of the future: true on errors
+QFuture<bool> ConfigLoader::loadAsync(const QString &fileName, QJsonObject *config, TestPatternGenerator *rules)
+{
+    return QtConcurrent::run(&ConfigLoader::loadTo, fileName, config, rules);
+}
+
+bool ConfigLoader::loadTo(const QString &fileName, QJsonObject *config, TestPatternGenerator *rules)
+{
+    return load(fileName, *config, rules);
+}
+
+// return true on errors
+bool ConfigLoader::load(const QString &fileName, QJsonObject &config, TestPatternGenerator *rules)
+{
+    if (!loadCache(fileName, config, rules))
+        return false;
+
+    QFile configFile(fileName);
+
+    if (!configFile.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "cannot open" << configFile.fileName();
+        return true;
+    }
+
+    QByteArray data = configFile.readAll();
+    configFile.close();
+
+    QJsonParseError parseError;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(data, &parseError);
+
+    if (parseError.error)
+    {
+        int line = data.left(parseError.offset).count('\n');
+        qWarning() << "json parse error in" << configFile.fileName() << "at line" << line << parseError.errorString();
+        return true;
+    }
+
+    if (!jsonDoc.isObject())
+    {
+        qWarning() << configFile.fileName() << "is not a JSON object";
+        return true;
+    }
+
+    config = jsonDoc.object();
+
+    if (rules)
+        rules->createFromRules(config[RulesSection].toObject());
+
+    saveCache(fileName, config, rules);
+
+    return false;
+}
+
+QString ConfigLoader::cacheFileName(const QString &fileName)
+{
+    QFileInfo info(fileName);
+    QString path = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    QByteArray hash = QCryptographicHash::hash(info.absoluteFilePath().toUtf8(), QCryptographicHash::Md5).toHex();
+
+    if (path.isEmpty() || !QDir().mkpath(path))
+        return QString();
+
+    return QDir(path).filePath(info.fileName() + "." + hash.left(8) + ".bin");
+}
+
+// return true on errors, i.e., cache is missing or out of date
+bool ConfigLoader::loadCache(const QString &fileName, QJsonObject &config, TestPatternGenerator *rules)
+{
+    QFileInfo info(fileName);
+    QFile cacheFile(cacheFileName(fileName));
+
+    if (!info.exists() || cacheFile.fileName().isEmpty() || !cacheFile.open(QIODevice::ReadOnly))
+        return true;
+
+    QDataStream in(&cacheFile);
+    in.setVersion(QDataStream::Qt_5_6);
+
+    quint32 magic, version;
+    qint64 size, modified;
+    bool hasRules;
+    QByteArray data;
+
+    in >> magic >> version >> size >> modified >> hasRules;
+
+    if ((magic != CACHE_MAGIC) || (version != CACHE_VERSION) ||
+            (size != info.size()) || (modified != info.lastModified().toMSecsSinceEpoch()) ||
+            (rules && !hasRules))
+        return true;
+
+    in >> data;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    config = QCborValue::fromCbor(data).toMap().toJsonObject();
+#else
+    config = QJsonDocument::fromBinaryData(data).object();
+#endif
+
+    if (config.isEmpty() || (in.status() != QDataStream::Ok))
+        return true;
+
+    if (rules && rules->load(in))
+        return true;
+
+    qDebug() << "configuration loaded from cache" << cacheFile.fileName();
+    return false;
+}
+
+void ConfigLoader::saveCache(const QString &fileName, const QJsonObject &config, const TestPatternGenerator *rules)
+{
+    QFileInfo info(fileName);
+    QFile cacheFile(cacheFileName(fileName));
+
+    if (cacheFile.fileName().isEmpty() || !cacheFile.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "cannot write configuration cache" << cacheFile.fileName();
+        return;
+    }
+
+    QDataStream out(&cacheFile);
+    out.setVersion(QDataStream::Qt_5_6);
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    QByteArray data = QCborValue::fromJsonValue(config).toCbor();
+#else
+    QByteArray data = QJsonDocument(config).toBinaryData();
+#endif
+
+    out << CACHE_MAGIC << CACHE_VERSION << qint64(info.size()) <<
+           qint64(info.lastModified().toMSecsSinceEpoch()) << bool(rules != 0) << data;
+
+    if (rules)
+        rules->save(out);
+
+    cacheFile.close();
+}
@@ -0,0 +1,33 @@
+#ifndef CONFIGLOADER_H
+#define CONFIGLOADER_H
+
+#include <QString>
+#include <QJsonObject>
+#include <QFuture>
+#include <testpatterngenerator.h>
+
+/**
+ * Loads a JSON configuration file.
+ *
+ * The parsed configuration and the compiled match rules (if requested) are
+ * stored in a binary cache file. As long as size and modification time of
+ * the configuration file are unchanged, the cache is loaded instead of
+ * parsing the file and compiling the rules again.
+ *
+ * A file can be loaded in a worker thread, overlapped with the startup of the
+ * application; config and rules must persist until the future is finished.
+ */
+class ConfigLoader
+{
+public:
+    static bool load(const QString &fileName, QJsonObject &config, TestPatternGenerator *rules = 0);
+    static QFuture<bool> loadAsync(const QString &fileName, QJsonObject *config, TestPatternGenerator *rules = 0);
+
+private:
+    static bool loadTo(const QString &fileName, QJsonObject *config, TestPatternGenerator *rules);
+    static QString cacheFileName(const QString &fileName);
+    static bool loadCache(const QString &fileName, QJsonObject &config, TestPatternGenerator *rules);
+    static void saveCache(const QString &fileName, const QJsonObject &config, const TestPatternGenerator *rules);
+};
+
+#endif // CONFIGLOADER_H
@@ -0,0 +1,243 @@
+#include "coveragegenerator.h"
+#include <QDebug>
+#include <fd.h>
+
+using namespace fd;
+
+CoverageGenerator::CoverageGenerator()
+{
+    mMode = ModeNone;
+    mMaxChar = DEV_MAX_CHAR_FD10;
+    mCntSharedPriority = 0;
+    mEvtName = mEvtType = mEvtTxt = 0;
+}
+
+CoverageGenerator::CoverageGenerator(Mode mode, const QList<uchar> &commands, int maxChar, StringPool &strings)
+{
+    mMode = mode;
+    mMaxChar = maxChar;
+    mCntSharedPriority = 0;
+
+    mEvtName = strings.intern(CallEvent);
+    mEvtType = strings.intern("coverage");
+    mEvtTxt = strings.intern(CallText);
+
+    // location text: event text + delimiter + location text = required length
+    for (int textLength = TextShort; textLength <= TextSliding; ++textLength)
+    {
+        int length = 1;
+
+        if (textLength == TextMaxChar)
+            length = mMaxChar - CallText.length() - 1;
+        else if (textLength == TextSliding)
+            length = 2 * mMaxChar - CallText.length() - 1;
+
+        for (int offset = 0; offset < 10; ++offset)
+        {
+            QString locTxt;
+
+            for (int i = 0; i < length; ++i)
+                locTxt.append(QChar('0' + (offset + i) % 10));
+
+            mLocTxt[textLength] << strings.intern(locTxt);
+        }
+    }
+
+    foreach (uchar cmd, commands)
+        mValues[ParamCmd] << cmd;
+
+    mValues[ParamBlink] << BLINK_NONE << BLINK_ALL << BLINK_EVENT << BLINK_LOCATION << BLINK_DELIMITER;
+    mValues[ParamTone] << TONE_NONE << TONE_CALL << TONE_ALARM;
+    mValues[ParamTextLength] << TextShort << TextMaxChar << TextSliding;
+    mValues[ParamPriority] << 0 << 1;   // unique priority, shared priority (multiple text)
+
+    if (mValues[ParamCmd].isEmpty())
+        mMode = ModeNone;
+
+    if (mMode == ModePairwise)
+    {
+        buildPairwise();
+
+        foreach (const QVector<uchar> &r, mRows)
+            mCntSharedPriority += r.at(ParamPriority);
+    }
+    else if (mMode == ModeFull)
+    {
+        mCntSharedPriority = count() / mValues[ParamPriority].count();
+    }
+
+    qDebug() << "coverage patterns:" << count();
+}
+
+CoverageGenerator::Mode CoverageGenerator::modeFromString(const QString &mode)
+{
+    if (mode == RulesCoverageFull)
+        return ModeFull;
+    else if (mode == RulesCoveragePairwise)
+        return ModePairwise;
+
+    return ModeNone;
+}
+
+quint64 CoverageGenerator::count() const
+{
+    if (mMode == ModePairwise)
+        return mRows.count();
+
+    if (mMode == ModeFull)
+    {
+        quint64 cnt = 1;
+
+        for (int k = 0; k < ParamCount; ++k)
+            cnt *= mValues[k].count();
+
+        return cnt;
+    }
+
+    return 0;
+}
+
+quint64 CoverageGenerator::countWithPriority(int prio) const
+{
+    if (prio == PRTY_COVERAGE)
+        return mCntSharedPriority;
+
+    if ((prio > PRTY_COVERAGE) && (quint64(prio - PRTY_COVERAGE) <= count()))
+        return 1;
+
+    return 0;
+}
+
+QVector<uchar> CoverageGenerator::row(quint64 idx) const
+{
+    if (mMode == ModePairwise)
+        return mRows.at(idx);
+
+    QVector<uchar> r(ParamCount);
+
+    for (int k = ParamCount - 1; k >= 0; --k)   // mixed radix, last parameter changes fastest
+    {
+        r[k] = idx % mValues[k].count();
+        idx /= mValues[k].count();
+    }
+
+    return r;
+}
+
+sTestPattern CoverageGenerator::at(quint64 idx) const
+{
+    sTestPattern testPattern;
+
+    if (idx >= count())
+        return testPattern;
+
+    QVector<uchar> r = row(idx);
+
+    testPattern.cmd = mValues[ParamCmd].at(r.at(ParamCmd));
+    testPattern.blink = mValues[ParamBlink].at(r.at(ParamBlink));
+    testPattern.tone = mValues[ParamTone].at(r.at(ParamTone));
+
+    if (mValues[ParamPriority].at(r.at(ParamPriority)))
+        testPattern.prio = PRTY_COVERAGE;
+    else
+        testPattern.prio = PRTY_COVERAGE + 1 + idx;
+
+    testPattern.evtName = mEvtName;
+    testPattern.evtType = mEvtType;
+    testPattern.evtTxt = mEvtTxt;
+    testPattern.locTxt = mLocTxt[mValues[ParamTextLength].at(r.at(ParamTextLength))].at(idx % 10);
+
+    return testPattern;
+}
+
+// greedy construction of a covering array of strength 2
+void CoverageGenerator::buildPairwise()
+{
+    QVector<bool> uncovered[ParamCount][ParamCount];
+    int cntUncovered = 0;
+
+    mRows.clear();
+
+    for (int k1 = 0; k1 < ParamCount; ++k1)
+    {
+        for (int k2 = k1 + 1; k2 < ParamCount; ++k2)
+        {
+            uncovered[k1][k2].fill(true, mValues[k1].count() * mValues[k2].count());
+            cntUncovered += uncovered[k1][k2].count();
+        }
+    }
+
+    while (cntUncovered)
+    {
+        QVector<uchar> r(ParamCount);
+        QVector<bool> isSet(ParamCount, false);
+
+        // seed the row with the 1st uncovered pair
+        for (int k1 = 0; (k1 < ParamCount) && !isSet.contains(true); ++k1)
+        {
+            for (int k2 = k1 + 1; (k2 < ParamCount) && !isSet.contains(true); ++k2)
+            {
+                int i = uncovered[k1][k2].indexOf(true);
+
+                if (i >= 0)
+                {
+                    r[k1] = i / mValues[k2].count();
+                    r[k2] = i % mValues[k2].count();
+                    isSet[k1] = isSet[k2] = true;
+                }
+            }
+        }
+
+        // fill other parameters with the values covering most uncovered pairs
+        for (int k = 0; k < ParamCount; ++k)
+        {
+            if (isSet.at(k))
+                continue;
+
+            int best = 0;
+            int bestCnt = -1;
+
+            for (int v = 0; v < mValues[k].count(); ++v)
+            {
+                int cnt = 0;
+
+                for (int j = 0; j < ParamCount; ++j)
+                {
+                    if (!isSet.at(j))
+                        continue;
+
+                    if (j < k)
+                        cnt += uncovered[j][k].at(r.at(j) * mValues[k].count() + v);
+                    else
+                        cnt += uncovered[k][j].at(v * mValues[j].count() + r.at(j));
+                }
+
+                if (cnt > bestCnt)
+                {
+                    bestCnt = cnt;
+                    best = v;
+                }
+            }
+
+            r[k] = best;
+            isSet[k] = true;
+        }
+
+        // mark pairs of the row as covered
+        for (int k1 = 0; k1 < ParamCount; ++k1)
+        {
+            for (int k2 = k1 + 1; k2 < ParamCount; ++k2)
+            {
+                int i = r.at(k1) * mValues[k2].count() + r.at(k2);
+
+                if (uncovered[k1][k2].at(i))
+                {
+                    uncovered[k1][k2][i] = false;
+                    --cntUncovered;
+                }
+            }
+        }
+
+        mRows.append(r);
+    }
+}
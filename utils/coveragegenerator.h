@@ -0,0 +1,66 @@
+#ifndef COVERAGEGENERATOR_H
+#define COVERAGEGENERATOR_H
+
+#include <QVector>
+#include <QList>
+#include <testpattern.h>
+#include <stringpool.h>
+
+/**
+ * Generates test patterns covering the parameter space of the LR protocols:
+ * command x blink mode x tone x text length x priority collision.
+ *
+ * In "full" mode the cross product is enumerated, a pattern is computed
+ * from its index. In "pairwise" mode a covering array is built, in which
+ * every pair of parameter values appears at least once.
+ */
+class CoverageGenerator
+{
+public:
+    enum Param {
+        ParamCmd = 0,
+        ParamBlink,
+        ParamTone,
+        ParamTextLength,
+        ParamPriority,
+        ParamCount
+    };
+
+    enum Mode {
+        ModeNone = 0,
+        ModeFull,
+        ModePairwise
+    };
+
+    enum TextLength {
+        TextShort = 0,  // few chars
+        TextMaxChar,    // exactly max number of chars of the device
+        TextSliding     // longer than the display
+    };
+
+    CoverageGenerator();
+    CoverageGenerator(Mode mode, const QList<uchar> &commands, int maxChar, StringPool &strings);
+
+    static Mode modeFromString(const QString &mode);
+
+    Mode mode() const { return mMode; }
+    quint64 count() const;
+    quint64 countWithPriority(int prio) const;
+    sTestPattern at(quint64 idx) const;     // idx = 0 .. count() - 1
+
+private:
+    Mode mMode;
+    int mMaxChar;
+    QVector<int> mValues[ParamCount];       // values of the parameters
+    QVector<QVector<uchar> > mRows;         // covering array (value indexes), pairwise mode
+    quint64 mCntSharedPriority;
+    quint32 mEvtName;
+    quint32 mEvtType;
+    quint32 mEvtTxt;
+    QVector<quint32> mLocTxt[TextSliding + 1];    // location texts per text length
+
+    void buildPairwise();
+    QVector<uchar> row(quint64 idx) const;
+};
+
+#endif // COVERAGEGENERATOR_H
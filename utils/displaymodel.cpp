@@ -0,0 +1,245 @@
+#include "displaymodel.h"
+#include <fd.h>
+
+using namespace fd;
+
+DisplayModel::DisplayModel()
+{
+    reset();
+}
+
+void DisplayModel::reset()
+{
+    mDisplayText.clear();
+    mCurrDisplayText.clear();
+    mIsMultipleText = false;
+    mTone = TONE_NONE;
+    mSlidingLength = 0;
+    mSlidingAndBlinking = false;
+
+    mNow = 0;
+    mBlinkDue = mSlidingDue = mSlidingDelayDue = -1;
+}
+
+void DisplayModel::setProtocol(const QByteArray &protocol, qint64 now)
+{
+    QByteArray frontText;
+    QByteArray backText;
+    char ch;
+    bool isBlinking = false;
+
+    advanceTo(now);
+    mSlidingDue = -1;
+
+    // extract text from byte protocol
+    if (protocol.at(PROT_HDR_CMD) == LR_CMD_28)
+    {
+        if (protocol.length() > (PROT_28_PL_DATA + protocol.at(PROT_28_PL_LENGTH)))
+        {
+            frontText = protocol.mid(PROT_28_PL_DATA, protocol.at(PROT_28_PL_LENGTH));
+            backText = frontText;
+        }
+
+        for (int i = 0; i < frontText.length(); ++i)
+        {
+            if (frontText.at(i) & BLINK_CHAR)
+            {
+                ch = frontText.at(i) & ~BLINK_CHAR;
+                frontText[i] = ch;
+
+                backText[i] = QChar::Space;
+                isBlinking = true;
+            }
+        }
+
+        mIsMultipleText = protocol.at(PROT_28_TXT_FORMAT) & MULTIPLE_TEXT;
+
+        if (protocol.at(PROT_28_TXT_FORMAT) & SLIDING_TEXT)
+        {
+            mSlidingDelayDue = mNow + UI_SLIDING_START_DELAY;
+            mSlidingAndBlinking = isBlinking;
+        }
+
+        mTone = TONE_NONE;
+        if (protocol.at(PROT_28_TONE) & TONE_CALL)
+            mTone = TONE_CALL;
+        else if (protocol.at(PROT_28_TONE) & TONE_ALARM)
+            mTone = TONE_ALARM;
+    }
+    else if ((protocol.at(PROT_HDR_CMD) == LR_CMD_26) ||
+             (protocol.at(PROT_HDR_CMD) == LR_CMD_27))
+    {
+
+        frontText = protocol.mid(PROT_26_PL_DATA, PROT_26_PL_LEN);
+        backText = frontText;
+
+        if (protocol.at(PROT_HDR_CMD) == LR_CMD_26)
+        {
+            for (int i = 0; i < frontText.length(); ++i)
+            {
+                if (frontText.at(i) & BLINK_CHAR)
+                {
+                    ch = frontText.at(i) & ~BLINK_CHAR;
+                    frontText[i] = ch;
+
+                    backText[i] = QChar::Space;
+                    isBlinking = true;
+                }
+            }
+        }
+        else if (protocol.at(PROT_HDR_CMD) == LR_CMD_27)
+        {
+            // blinking all or not
+            if (frontText.at(0) & BLINK_CHAR)
+            {
+                isBlinking = true;
+
+                for (int i = 0; i < frontText.length(); ++i)
+                {
+                    if (frontText.at(i) & BLINK_CHAR)
+                    {
+                        ch = frontText.at(i) & ~BLINK_CHAR;
+                        frontText[i] = ch;
+                    }
+
+                    backText[i] = QChar::Space;
+                }
+            }
+
+            // insert extra space between Rufart and Adress for command 0x27
+            QByteArray temp = frontText;
+
+            frontText = temp.left(1);
+            frontText.append(QChar::Space);
+            frontText.append(temp.mid(1));
+
+            temp = backText;
+
+            backText = temp.left(1);
+            backText.append(QChar::Space);
+            backText.append(temp.mid(1));
+        }
+
+        mTone = TONE_NONE;
+        uchar tone = protocol.at(PROT_26_PRIORITY);
+        if (tone == PROT_26_TONE_CALL)
+            mTone = TONE_CALL;
+        else if (tone > PROT_26_TONE_CALL)
+            mTone = TONE_ALARM;
+    }
+
+    // display text
+    mDisplayText.clear();
+    mCurrDisplayText = QString::fromUtf8(frontText);
+    mDisplayText.append(mCurrDisplayText);
+    if (isBlinking)
+    {
+        mDisplayText.append(QString::fromUtf8(backText));
+
+        if (mBlinkDue < 0)
+            mBlinkDue = mNow + UI_PERIOD_BLINK;
+    }
+    else
+    {
+        mBlinkDue = -1;
+    }
+}
+
+qint64 DisplayModel::nextEvent() const
+{
+    qint64 due = -1;
+
+    foreach (qint64 t, QList<qint64>() << mBlinkDue << mSlidingDelayDue << mSlidingDue)
+    {
+        if ((t >= 0) && ((due < 0) || (t < due)))
+            due = t;
+    }
+
+    return due;
+}
+
+// process the timer events up to the given time
+void DisplayModel::advanceTo(qint64 now)
+{
+    qint64 due;
+
+    while (((due = nextEvent()) >= 0) && (due <= now))
+    {
+        mNow = due;
+
+        // periodic timers are rescheduled before their handler, which may stop or restart them
+        if (mBlinkDue == due)
+        {
+            mBlinkDue += UI_PERIOD_BLINK;
+            onBlinkTimerTimeout();
+        }
+        else if (mSlidingDelayDue == due)
+        {
+            mSlidingDelayDue = -1;  // single shot
+            onSlidingDelayTimerTimeout();
+        }
+        else
+        {
+            mSlidingDue += UI_SLIDING_CHAR_RATE;
+            onSlidingTimerTimeout();
+        }
+    }
+
+    if (now > mNow)
+        mNow = now;
+}
+
+void DisplayModel::onBlinkTimerTimeout()
+{
+    QString text = mCurrDisplayText;
+
+    if (mDisplayText.first().contains(text))
+        mCurrDisplayText = mDisplayText.last();
+    else
+        mCurrDisplayText = mDisplayText.first();
+}
+
+void DisplayModel::onSlidingDelayTimerTimeout()
+{
+    if (mSlidingDue < 0)
+    {
+        mSlidingDue = mNow + UI_SLIDING_CHAR_RATE;
+        mSlidingLength = mCurrDisplayText.length();
+
+        if (mSlidingAndBlinking)
+        {
+            mBlinkDue = -1;
+            mCurrDisplayText = mDisplayText.first();
+        }
+    }
+}
+
+void DisplayModel::onSlidingTimerTimeout()
+{
+    QString text;
+
+    if (mDisplayText.size())
+    {
+        --mSlidingLength;
+
+        if (mSlidingLength)
+        {
+            text = mCurrDisplayText.right(mSlidingLength);
+        }
+        else
+        {
+            text = mDisplayText.first();
+            mSlidingLength = text.length();
+            mSlidingDue = -1;
+            mSlidingDelayDue = mNow + UI_SLIDING_START_DELAY;
+
+            if (mSlidingAndBlinking)
+            {
+                if (mBlinkDue < 0)
+                    mBlinkDue = mNow + UI_PERIOD_BLINK;
+            }
+        }
+
+        mCurrDisplayText = text;
+    }
+}
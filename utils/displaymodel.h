@@ -0,0 +1,48 @@
+#ifndef DISPLAYMODEL_H
+#define DISPLAYMODEL_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+/**
+ * Emulated display state of a Flurdisplay.
+ *
+ * Decodes a sent LR protocol into display text, multiple text indicator
+ * and tone, and animates blinking and sliding text. Timers are kept as
+ * deadlines in milliseconds of an external time base, so that the display
+ * can be driven by the GUI in real time or rendered in virtual time.
+ */
+class DisplayModel
+{
+public:
+    DisplayModel();
+
+    void reset();
+    void setProtocol(const QByteArray &protocol, qint64 now);
+    void advanceTo(qint64 now);
+    qint64 nextEvent() const;   // time of the next timer event, -1 if no timer is active
+
+    const QString &text() const { return mCurrDisplayText; }
+    bool isMultipleText() const { return mIsMultipleText; }
+    int tone() const { return mTone; }     // TONE_NONE, TONE_CALL or TONE_ALARM
+
+private:
+    QStringList mDisplayText;   // front text, back text (if blinking)
+    QString mCurrDisplayText;   // text on display
+    bool mIsMultipleText;
+    int mTone;
+    int mSlidingLength;
+    bool mSlidingAndBlinking;   // sliding with blinking, only for 0x28 command
+
+    qint64 mNow;
+    qint64 mBlinkDue;           // deadlines of the timers, -1 if stopped
+    qint64 mSlidingDue;
+    qint64 mSlidingDelayDue;
+
+    void onBlinkTimerTimeout();
+    void onSlidingTimerTimeout();
+    void onSlidingDelayTimerTimeout();
+};
+
+#endif // DISPLAYMODEL_H
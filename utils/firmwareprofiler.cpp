@@ -0,0 +1,356 @@
+#include "firmwareprofiler.h"
+#include <QDebug>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QHash>
+#include <algorithm>
+#include <fd.h>
+#include <testmanager.h>
+#include <serialprotocol.h>
+#include <configloader.h>
+#include <frameencoder.h>
+
+using namespace fd;
+
+FirmwareProfiler::FirmwareProfiler(TestManager *testManager, SerialProtocol *serialProtocol, const QJsonObject &config,
+                                   QObject *parent) :
+    QObject(parent)
+{
+    mTestManager = testManager;
+    mSerialProtocol = serialProtocol;
+    mConfig = config;
+    mClock = Clock::system();
+    mIsSeriobus = false;
+    mIsRunning = false;
+    mIsSent = false;
+    mRepeat = 100;
+    mActive = 0;
+    mSentTime = 0;
+
+    mResponseTimer.setSingleShot(true);
+    mResponseTimer.setInterval(500);
+
+    connect(&mResponseTimer, SIGNAL(timeout()), this, SLOT(onResponseTimeout()));
+    connect(mSerialProtocol, SIGNAL(sentFrame(QByteArray)), this, SLOT(onSentFrame()));
+    connect(mSerialProtocol, SIGNAL(receivedACK()), this, SLOT(onReceivedACK()));
+    connect(mSerialProtocol, SIGNAL(receivedNACK()), this, SLOT(onReceivedNACK()));
+}
+
+void FirmwareProfiler::setClock(Clock *clock)
+{
+    mClock = clock ? clock : Clock::system();
+    mResponseTimer.setClock(clock);
+}
+
+// time in us, high resolution on the system clock
+qint64 FirmwareProfiler::now() const
+{
+    return mClock->isVirtual() ? mClock->now() * 1000 : mElapsed.nsecsElapsed() / 1000;
+}
+
+void FirmwareProfiler::start()
+{
+    int maxChar = mConfig[DevSection].toObject()[DevMaxChar].toInt(DEV_MAX_CHAR_FD10);
+
+    mSeries.clear();
+
+    // series per command and payload length: short, half, full, sliding and long text
+    foreach (uchar cmd, mTestManager->commands())
+    {
+        QList<int> lengths;
+
+        if (cmd == LR_CMD_28)
+        {
+            foreach (int length, QList<int>() << 1 << maxChar / 2 << maxChar << 2 * maxChar << 4 * maxChar)
+            {
+                length = qBound(1, length, 255);
+
+                if (!lengths.contains(length))
+                    lengths << length;
+            }
+        }
+        else
+        {
+            lengths << ((cmd == LR_CMD_26) ? PROT_26_PL_LEN : PROT_27_PL_LEN);   // fixed payload
+        }
+
+        foreach (int length, lengths)
+        {
+            sSeries series;
+
+            series.cmd = cmd;
+            series.length = length;
+            series.sent = series.ack = series.nack = series.timeout = 0;
+            series.latencies.reserve(mRepeat);
+
+            mSeries.append(series);
+        }
+    }
+
+    if (mSeries.isEmpty() || (mRepeat <= 0))
+    {
+        qWarning() << "firmware profiler: no commands";
+        emit finished();
+        return;
+    }
+
+    mIsSeriobus = mTestManager->isSeriobus();
+    mIsRunning = true;
+    mActive = 0;
+    mProtocol = makeProtocol(mSeries.first().cmd, mSeries.first().length, maxChar);
+    mElapsed.start();
+
+    sendNext();
+}
+
+void FirmwareProfiler::stop()
+{
+    if (!mIsRunning)
+        return;
+
+    mIsRunning = false;
+    mResponseTimer.stop();
+
+    report();
+    emit finished();
+}
+
+void FirmwareProfiler::sendNext()
+{
+    if (!mIsRunning)
+        return;
+
+    if (mSeries.at(mActive).sent >= quint64(mRepeat))
+    {
+        if (++mActive >= mSeries.count())
+        {
+            stop();
+            return;
+        }
+
+        mProtocol = makeProtocol(mSeries.at(mActive).cmd, mSeries.at(mActive).length,
+                                 mConfig[DevSection].toObject()[DevMaxChar].toInt(DEV_MAX_CHAR_FD10));
+    }
+
+    QByteArray protocol = mProtocol;
+
+    if (mIsSeriobus)
+        protocol.prepend('W');
+
+    ++mSeries[mActive].sent;
+    mIsSent = false;
+    mSentTime = now();
+
+    mSerialProtocol->sendFrame(SerialProtocol::frame(protocol));
+    mResponseTimer.start();
+}
+
+// end of transmission, the response time starts
+void FirmwareProfiler::onSentFrame()
+{
+    if (!mIsRunning || !mResponseTimer.isActive())
+        return;
+
+    mIsSent = true;
+    mSentTime = now();
+    mResponseTimer.start();
+}
+
+void FirmwareProfiler::onReceivedACK()
+{
+    if (!mIsRunning || !mResponseTimer.isActive())
+        return;
+
+    sSeries &series = mSeries[mActive];
+
+    ++series.ack;
+    series.latencies.append(mIsSent ? now() - mSentTime : 0);   // 0: response before end of transmission
+    finish();
+}
+
+void FirmwareProfiler::onReceivedNACK()
+{
+    if (!mIsRunning || !mResponseTimer.isActive())
+        return;
+
+    ++mSeries[mActive].nack;
+    finish();
+}
+
+void FirmwareProfiler::onResponseTimeout()
+{
+    if (!mIsRunning)
+        return;
+
+    ++mSeries[mActive].timeout;
+    sendNext();
+}
+
+void FirmwareProfiler::finish()
+{
+    mResponseTimer.stop();
+    sendNext();
+}
+
+// protocol with a payload of given length, like the test patterns of the command
+QByteArray FirmwareProfiler::makeProtocol(uchar cmd, int length, int maxChar)
+{
+    QByteArray protocol = TestManager::makeLrProtocolHeader(cmd);
+    QByteArray payload;
+
+    for (int i = 0; i < length; ++i)
+        payload.append(char('0' + i % 10));
+
+    if (cmd == LR_CMD_28)
+    {
+        protocol[PROT_28_PL_LENGTH] = length;
+        protocol[PROT_28_TXT_FORMAT] = ALIGN_LEFT | ((length > maxChar) ? SLIDING_TEXT : 0);
+        payload.append(char(FrameEncoder::checksum(payload.constData(), payload.length())));
+    }
+    else
+    {
+        protocol.append(char(0));   // valence: no tone
+    }
+
+    protocol.append(payload);
+    return protocol;
+}
+
+qint64 FirmwareProfiler::percentile(const QVector<qint64> &sorted, double p)
+{
+    if (sorted.isEmpty())
+        return -1;
+
+    return sorted.at(qMin(sorted.count() - 1, int(p * sorted.count())));
+}
+
+QJsonObject FirmwareProfiler::toJson(const sSeries &series)
+{
+    QJsonObject object;
+    QVector<qint64> sorted = series.latencies;
+    qint64 sum = 0;
+
+    std::sort(sorted.begin(), sorted.end());
+
+    foreach (qint64 latency, sorted)
+        sum += latency;
+
+    object[ProfileCmd] = QString("0x%1").arg(series.cmd, 2, 16, QChar('0'));
+    object[ProfileLength] = series.length;
+    object[ProfileSent] = double(series.sent);
+    object[ProfileAck] = double(series.ack);
+    object[ProfileNack] = double(series.nack);
+    object[ProfileTimeout] = double(series.timeout);
+    object[ProfileLatencyMin] = double(percentile(sorted, 0));
+    object[ProfileLatencyP50] = double(percentile(sorted, 0.5));
+    object[ProfileLatencyP90] = double(percentile(sorted, 0.9));
+    object[ProfileLatencyP99] = double(percentile(sorted, 0.99));
+    object[ProfileLatencyMax] = double(sorted.isEmpty() ? -1 : sorted.last());
+    object[ProfileLatencyMean] = double(sorted.isEmpty() ? -1 : sum / sorted.count());
+
+    return object;
+}
+
+QJsonObject FirmwareProfiler::results() const
+{
+    QJsonObject object;
+    QJsonArray series;
+
+    foreach (const sSeries &s, mSeries)
+        series.append(toJson(s));
+
+    object[ProfileDevice] = mConfig[DevSection].toObject()[ConfigName].toString();
+    object[ProfileFirmware] = mConfig[FirmwareSection].toObject()[ConfigName].toString();
+    object[ProfileDevInterface] = mConfig[DevInterfaceSection].toObject()[ConfigName].toString();
+    object[ProfileDate] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    object[ProfileRepeat] = mRepeat;
+    object[ProfileSeries] = series;
+
+    return object;
+}
+
+// return true on errors
+bool FirmwareProfiler::save(const QString &fileName) const
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "cannot create profile" << fileName;
+        return true;
+    }
+
+    file.write(QJsonDocument(results()).toJson());
+    return false;
+}
+
+void FirmwareProfiler::report() const
+{
+    foreach (const sSeries &s, mSeries)
+    {
+        QJsonObject object = toJson(s);
+
+        qDebug().noquote() << QString("%1 length %2: %3 sent, %4 nack, %5 timeout, latency p50 %6 us, p90 %7 us, p99 %8 us")
+                              .arg(object[ProfileCmd].toString()).arg(s.length).arg(s.sent).arg(s.nack).arg(s.timeout)
+                              .arg(object[ProfileLatencyP50].toDouble()).arg(object[ProfileLatencyP90].toDouble())
+                              .arg(object[ProfileLatencyP99].toDouble());
+    }
+}
+
+// print the changes of the profile against the base profile, return true on errors
+bool FirmwareProfiler::compare(const QString &baseFileName, const QString &fileName)
+{
+    QJsonObject base;
+    QJsonObject profile;
+    QHash<QString, QJsonObject> baseSeries;
+
+    if (ConfigLoader::load(baseFileName, base) || ConfigLoader::load(fileName, profile))
+        return true;
+
+    foreach (const QJsonValue &value, base[ProfileSeries].toArray())
+    {
+        QJsonObject series = value.toObject();
+        baseSeries.insert(series[ProfileCmd].toString() + "/" + QString::number(series[ProfileLength].toInt()), series);
+    }
+
+    qDebug().noquote() << QString("%1 %2 %3 -> %4 %5 %6")
+                          .arg(base[ProfileDevice].toString(), base[ProfileDevInterface].toString(),
+                               base[ProfileFirmware].toString(), profile[ProfileDevice].toString(),
+                               profile[ProfileDevInterface].toString(), profile[ProfileFirmware].toString());
+
+    foreach (const QJsonValue &value, profile[ProfileSeries].toArray())
+    {
+        QJsonObject series = value.toObject();
+        QString key = series[ProfileCmd].toString() + "/" + QString::number(series[ProfileLength].toInt());
+
+        if (!baseSeries.contains(key))
+        {
+            qDebug().noquote() << key << "not in base profile";
+            continue;
+        }
+
+        const QJsonObject &other = baseSeries[key];
+        QString line = key;
+
+        foreach (const QString &field, QStringList() << ProfileLatencyP50 << ProfileLatencyP90 << ProfileLatencyP99)
+        {
+            double before = other[field].toDouble();
+            double after = series[field].toDouble();
+
+            line += QString(", %1 %2 -> %3 us").arg(field).arg(before).arg(after);
+
+            if (before > 0)
+                line += QString(" (%1%2%)").arg(after >= before ? "+" : "").arg(100 * (after - before) / before, 0, 'f', 1);
+        }
+
+        line += QString(", nack %1 -> %2, timeout %3 -> %4")
+                .arg(other[ProfileNack].toDouble()).arg(series[ProfileNack].toDouble())
+                .arg(other[ProfileTimeout].toDouble()).arg(series[ProfileTimeout].toDouble());
+
+        qDebug().noquote() << line;
+    }
+
+    return false;
+}
@@ -0,0 +1,88 @@
+#ifndef FIRMWAREPROFILER_H
+#define FIRMWAREPROFILER_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QVector>
+#include <clock.h>
+
+class TestManager;
+class SerialProtocol;
+
+/**
+ * Response time profiler of the device firmware.
+ *
+ * Per supported command and payload length, a series of frames is sent
+ * back to back. The ACK latency (end of transmission to response) and the
+ * NACK and timeout rates are measured per series. Results are tagged by
+ * device type, device interface and firmware version, and are saved as JSON
+ * so that runs of different firmware versions can be compared.
+ */
+class FirmwareProfiler : public QObject
+{
+    Q_OBJECT
+public:
+    struct sSeries {
+        uchar cmd;
+        int length;                 // payload length
+        quint64 sent;
+        quint64 ack;
+        quint64 nack;
+        quint64 timeout;
+        QVector<qint64> latencies;  // ACK latencies in us
+    };
+
+    FirmwareProfiler(TestManager *testManager, SerialProtocol *serialProtocol, const QJsonObject &config,
+                     QObject *parent = 0);
+
+    void setClock(Clock *clock);
+    void setRepeat(int repeat) { mRepeat = repeat; }
+    void setResponseTimeout(int msec) { mResponseTimer.setInterval(msec); }
+
+    const QList<sSeries> &series() const { return mSeries; }
+    QJsonObject results() const;
+    bool save(const QString &fileName) const;
+    void report() const;
+
+    static bool compare(const QString &baseFileName, const QString &fileName);
+
+signals:
+    void finished();
+
+public slots:
+    void start();
+    void stop();
+
+private slots:
+    void onSentFrame();
+    void onReceivedACK();
+    void onReceivedNACK();
+    void onResponseTimeout();
+
+private:
+    TestManager *mTestManager;
+    SerialProtocol *mSerialProtocol;
+    QJsonObject mConfig;
+    Clock *mClock;
+    ClockTimer mResponseTimer;
+    QElapsedTimer mElapsed;
+    QList<sSeries> mSeries;
+    QByteArray mProtocol;       // protocol of the running series
+    bool mIsSeriobus;
+    bool mIsRunning;
+    bool mIsSent;               // frame transmitted, waiting for response
+    int mRepeat;                // frames per series
+    int mActive;                // index of the running series
+    qint64 mSentTime;           // us
+
+    qint64 now() const;
+    void sendNext();
+    void finish();
+
+    static QByteArray makeProtocol(uchar cmd, int length, int maxChar);
+    static QJsonObject toJson(const sSeries &series);
+    static qint64 percentile(const QVector<qint64> &sorted, double p);
+};
+
+#endif // FIRMWAREPROFILER_H
@@ -0,0 +1,188 @@
+#include "goldencorpus.h"
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <fd.h>
+#include <framecorpus.h>
+#include <serialprotocol.h>
+#include <testmanager.h>
+
+using namespace fd;
+
+GoldenCorpus::GoldenCorpus(const QJsonObject &configOptions, const QJsonObject &test, const TestPatternGenerator &rules) :
+    mVariants(variants(configOptions)), mTest(test), mRules(rules)
+{
+}
+
+// one variant per device type and device interface of the configuration options
+QList<GoldenCorpus::sVariant> GoldenCorpus::variants(const QJsonObject &configOptions)
+{
+    QList<sVariant> list;
+    QJsonArray devices = configOptions[DevSection].toArray();
+    QJsonArray interfaces = configOptions[DevInterfaceSection].toArray();
+    QJsonObject firmware = configOptions[FirmwareSection].toArray().at(0).toObject();
+
+    foreach (const QJsonValue &device, devices)
+    {
+        foreach (const QJsonValue &devInterface, interfaces)
+        {
+            sVariant variant;
+
+            variant.name = device.toObject()[ConfigName].toString() + "_" +
+                    devInterface.toObject()[ConfigName].toString();
+            variant.config[DevSection] = device;
+            variant.config[DevInterfaceSection] = devInterface;
+            variant.config[FirmwareSection] = firmware;
+
+            list.append(variant);
+        }
+    }
+
+    return list;
+}
+
+// write golden frames of all variants, return true on errors
+bool GoldenCorpus::write(const QString &dir)
+{
+    bool error = false;
+
+    if (!QDir().mkpath(dir))
+    {
+        qWarning() << "cannot create golden directory" << dir;
+        return true;
+    }
+
+    foreach (const sVariant &variant, mVariants)
+    {
+        SerialProtocol serialProtocol;
+        TestManager testManager(&serialProtocol, variant.config, mTest, &mRules);
+
+        error |= testManager.writeCorpus(QDir(dir).filePath(variant.name + ".fdc"));
+    }
+
+    return error;
+}
+
+// compare encoded frames of all variants with the golden frames, return number of mismatches
+int GoldenCorpus::check(const QString &dir, int maxReports)
+{
+    static const quint64 BATCH_SIZE = 65536;
+    QElapsedTimer timer;
+    quint64 cntFrames = 0;
+    int cntMismatch = 0;
+
+    timer.start();
+
+    foreach (const sVariant &variant, mVariants)
+    {
+        SerialProtocol serialProtocol;
+        TestManager testManager(&serialProtocol, variant.config, mTest, &mRules);
+        FrameCorpus golden;
+        quint64 cntPatterns = testManager.testPatterns().count();
+
+        if (golden.open(QDir(dir).filePath(variant.name + ".fdc")))
+        {
+            ++cntMismatch;
+            continue;
+        }
+
+        if ((golden.commands() != testManager.commands()) || (golden.patternCount() != cntPatterns))
+        {
+            qWarning() << variant.name << ": pattern set changed, golden" << golden.patternCount() <<
+                          "patterns, actual" << cntPatterns;
+            ++cntMismatch;
+            continue;
+        }
+
+        foreach (uchar cmd, golden.commands())
+        {
+            for (quint64 id = 1; id <= cntPatterns; id += BATCH_SIZE)
+            {
+                QVector<QByteArray> frames = testManager.encodeBatch(cmd, id, qMin(BATCH_SIZE, cntPatterns - id + 1));
+
+                for (int i = 0; i < frames.count(); ++i)
+                {
+                    QByteArray expected = golden.frame(cmd, id + i);
+
+                    if (expected == frames.at(i))
+                        continue;
+
+                    if (cntMismatch++ < maxReports)
+                    {
+                        qWarning().noquote() << QString("%1: cmd 0x%2, pattern %3: %4")
+                                                .arg(variant.name)
+                                                .arg(cmd, 2, 16, QChar('0'))
+                                                .arg(id + i)
+                                                .arg(describeDiff(expected, frames.at(i)));
+                    }
+                }
+
+                cntFrames += frames.count();
+            }
+        }
+    }
+
+    qDebug() << "golden check:" << cntFrames << "frames," << cntMismatch << "mismatches in" << timer.elapsed() << "ms";
+    return cntMismatch;
+}
+
+// decode the first differing field of two frames
+QString GoldenCorpus::describeDiff(const QByteArray &expected, const QByteArray &actual)
+{
+    if (expected == actual)
+        return QString();
+
+    QByteArray expProtocol = SerialProtocol::unframe(expected);
+    QByteArray actProtocol = SerialProtocol::unframe(actual);
+
+    if (expProtocol == actProtocol)
+        return QString("framing: expected \"%1\", actual \"%2\"")
+                .arg(QString::fromLatin1(expected.left(2)), QString::fromLatin1(actual.left(2)));
+
+    int idx = 0;
+
+    while ((idx < expProtocol.length()) && (idx < actProtocol.length()) &&
+           (expProtocol.at(idx) == actProtocol.at(idx)))
+    {
+        ++idx;
+    }
+
+    if ((idx == expProtocol.length()) || (idx == actProtocol.length()))
+        return QString("length: expected %1, actual %2").arg(expProtocol.length()).arg(actProtocol.length());
+
+    return QString("%1 (byte %2): expected 0x%3, actual 0x%4")
+            .arg(fieldName(expProtocol, idx))
+            .arg(idx)
+            .arg((uchar)expProtocol.at(idx), 2, 16, QChar('0'))
+            .arg((uchar)actProtocol.at(idx), 2, 16, QChar('0'));
+}
+
+QString GoldenCorpus::fieldName(const QByteArray &protocol, int idx)
+{
+    static const char *fields28[] = {
+        "sender", "command", "destination station", "destination room", "source station",
+        "source room", "device type", "station group", "room group", "message id",
+        "tone", "text format", "text color", "priority", "payload length"
+    };
+    static const char *fields26[] = { "sender", "command", "group", "valence" };
+
+    if (protocol.length() <= PROT_HDR_CMD)
+        return "header";
+
+    if (protocol.at(PROT_HDR_CMD) == LR_CMD_28)
+    {
+        if (idx < PROT_28_PL_DATA)
+            return fields28[idx];
+
+        if (idx == protocol.length() - 1)
+            return "crc";
+
+        return QString("text[%1]").arg(idx - PROT_28_PL_DATA);
+    }
+
+    if (idx < PROT_26_PL_DATA)
+        return fields26[idx];
+
+    return QString("text[%1]").arg(idx - PROT_26_PL_DATA);
+}
@@ -0,0 +1,41 @@
+#ifndef GOLDENCORPUS_H
+#define GOLDENCORPUS_H
+
+#include <QString>
+#include <QList>
+#include <QJsonObject>
+#include <testpatterngenerator.h>
+
+/**
+ * Regression check of the protocol encoder against stored (golden) frames.
+ *
+ * The full pattern set is encoded for each device type (FD10, FD15, FD20)
+ * and device interface of the configuration options and compared byte by
+ * byte with the frame corpus of the variant in the golden directory.
+ * The first differing field of a mismatching frame is decoded.
+ */
+class GoldenCorpus
+{
+public:
+    struct sVariant {
+        QString name;
+        QJsonObject config;
+    };
+
+    GoldenCorpus(const QJsonObject &configOptions, const QJsonObject &test, const TestPatternGenerator &rules);
+
+    bool write(const QString &dir);
+    int check(const QString &dir, int maxReports = 10);
+
+    static QString describeDiff(const QByteArray &expected, const QByteArray &actual);
+    static QList<sVariant> variants(const QJsonObject &configOptions);
+
+private:
+    QList<sVariant> mVariants;
+    QJsonObject mTest;
+    const TestPatternGenerator &mRules;
+
+    static QString fieldName(const QByteArray &protocol, int idx);
+};
+
+#endif // GOLDENCORPUS_H
@@ -0,0 +1,244 @@
+#include "goldentimeline.h"
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <fd.h>
+#include <displaymodel.h>
+#include <serialprotocol.h>
+#include <testmanager.h>
+
+using namespace fd;
+
+GoldenTimeline::GoldenTimeline(const QJsonObject &configOptions, const QJsonObject &test, const TestPatternGenerator &rules) :
+    mVariants(GoldenCorpus::variants(configOptions)), mTest(test), mRules(rules)
+{
+}
+
+// write golden timelines of all variants, return true on errors
+bool GoldenTimeline::write(const QString &dir)
+{
+    if (!QDir().mkpath(dir))
+    {
+        qWarning() << "cannot create golden directory" << dir;
+        return true;
+    }
+
+    foreach (const GoldenCorpus::sVariant &variant, mVariants)
+    {
+        QFile file(QDir(dir).filePath(variant.name + ".fdt"));
+
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            qWarning() << "cannot create display timeline" << file.fileName();
+            return true;
+        }
+
+        foreach (const QByteArray &line, renderVariant(variant))
+            file.write(line + "\n");
+    }
+
+    return false;
+}
+
+// compare timelines of all variants with the golden timelines, return number of mismatches
+int GoldenTimeline::check(const QString &dir, int maxReports)
+{
+    QElapsedTimer timer;
+    quint64 cntTimelines = 0;
+    int cntMismatch = 0;
+
+    timer.start();
+
+    foreach (const GoldenCorpus::sVariant &variant, mVariants)
+    {
+        QFile file(QDir(dir).filePath(variant.name + ".fdt"));
+
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            qWarning() << "cannot open display timeline" << file.fileName();
+            ++cntMismatch;
+            continue;
+        }
+
+        QList<QByteArray> golden = file.readAll().split('\n');
+        QList<QByteArray> actual = renderVariant(variant);
+
+        if (!golden.isEmpty() && golden.last().isEmpty())
+            golden.removeLast();
+
+        if (golden.count() != actual.count())
+        {
+            qWarning() << variant.name << ": pattern set changed, golden" << golden.count() <<
+                          "timelines, actual" << actual.count();
+            ++cntMismatch;
+            continue;
+        }
+
+        for (int i = 0; i < actual.count(); ++i)
+        {
+            if (golden.at(i) == actual.at(i))
+                continue;
+
+            if (cntMismatch++ < maxReports)
+            {
+                qWarning().noquote() << QString("%1: %2: %3")
+                                        .arg(variant.name)
+                                        .arg(QString::fromUtf8(actual.at(i).left(actual.at(i).indexOf(' ', 3))))
+                                        .arg(describeDiff(golden.at(i), actual.at(i)));
+            }
+        }
+
+        cntTimelines += actual.count();
+    }
+
+    qDebug() << "golden timeline check:" << cntTimelines << "timelines," << cntMismatch << "mismatches in" << timer.elapsed() << "ms";
+    return cntMismatch;
+}
+
+// timelines of all patterns for all commands of the variant
+QList<QByteArray> GoldenTimeline::renderVariant(const GoldenCorpus::sVariant &variant) const
+{
+    SerialProtocol serialProtocol;
+    TestManager testManager(&serialProtocol, variant.config, mTest, &mRules);
+    const TestPatternGenerator &testPatterns = testManager.testPatterns();
+    QList<QByteArray> timelines;
+
+    foreach (uchar cmd, testManager.commands())
+    {
+        QByteArray cmdHeader = TestManager::makeLrProtocolHeader(cmd);
+
+        for (TestPatternGenerator::const_iterator itr = testPatterns.begin(); itr != testPatterns.end(); ++itr)
+        {
+            sTestPattern testPattern = *itr;
+            QByteArray header = testPattern.cmd ? TestManager::makeLrProtocolHeader(testPattern.cmd) : cmdHeader;
+            int interval = PERIOD_TEXT;
+            QByteArray protocol = testManager.encodeLrProtocol(testPattern, header, false, &interval);
+            QByteArray timeline = QByteArray::number(cmd, 16) + " " + QByteArray::number(itr.id()) + " ";
+
+            if (protocol.isEmpty())
+                timeline += "-";
+            else
+                timeline += render(protocol, interval);
+
+            timelines.append(timeline);
+        }
+    }
+
+    return timelines;
+}
+
+// run length encoded display timeline of the protocol shown for duration ms
+QByteArray GoldenTimeline::render(const QByteArray &protocol, int duration)
+{
+    DisplayModel display;
+    QByteArray timeline;
+    qint64 since = 0;
+    qint64 due;
+
+    display.setProtocol(protocol, 0);
+
+    timeline += QByteArray::number(display.tone(), 16) + " " + (display.isMultipleText() ? ":" : "-");
+
+    QString text = display.text();
+
+    while (((due = display.nextEvent()) >= 0) && (due < duration))
+    {
+        display.advanceTo(due);
+
+        if (display.text() != text)
+        {
+            appendRun(timeline, due - since, text);
+            text = display.text();
+            since = due;
+        }
+    }
+
+    appendRun(timeline, duration - since, text);
+
+    return timeline;
+}
+
+void GoldenTimeline::appendRun(QByteArray &timeline, qint64 duration, const QString &text)
+{
+    QByteArray escaped = text.toUtf8();
+
+    escaped.replace('\\', "\\\\");
+    escaped.replace('"', "\\\"");
+
+    timeline += " " + QByteArray::number(duration) + "\"" + escaped + "\"";
+}
+
+// split a timeline into its prefix (cmd, id, tone, multiple text) and runs (duration, text)
+QList<QPair<qint64, QByteArray> > GoldenTimeline::parseRuns(const QByteArray &line, QByteArray &prefix)
+{
+    QList<QPair<qint64, QByteArray> > runs;
+    int pos = line.indexOf('"');
+
+    if (pos < 0)
+    {
+        prefix = line;
+        return runs;
+    }
+
+    pos = line.lastIndexOf(' ', pos);
+    prefix = line.left(pos);
+
+    while (pos < line.length())
+    {
+        int quote = line.indexOf('"', pos);
+
+        if (quote < 0)
+            break;
+
+        qint64 duration = line.mid(pos + 1, quote - pos - 1).toLongLong();
+        QByteArray text;
+
+        for (pos = quote + 1; (pos < line.length()) && (line.at(pos) != '"'); ++pos)
+        {
+            if ((line.at(pos) == '\\') && (pos + 1 < line.length()))
+                ++pos;
+
+            text += line.at(pos);
+        }
+
+        runs.append(qMakePair(duration, text));
+        ++pos;  // closing quote
+    }
+
+    return runs;
+}
+
+// decode the first difference of two timelines
+QString GoldenTimeline::describeDiff(const QByteArray &expected, const QByteArray &actual)
+{
+    QByteArray expPrefix;
+    QByteArray actPrefix;
+    QList<QPair<qint64, QByteArray> > expRuns = parseRuns(expected, expPrefix);
+    QList<QPair<qint64, QByteArray> > actRuns = parseRuns(actual, actPrefix);
+
+    if (expPrefix != actPrefix)
+        return QString("tone/multiple text: expected \"%1\", actual \"%2\"")
+                .arg(QString::fromUtf8(expPrefix), QString::fromUtf8(actPrefix));
+
+    qint64 t = 0;
+
+    for (int i = 0; (i < expRuns.count()) && (i < actRuns.count()); ++i)
+    {
+        if (expRuns.at(i).second != actRuns.at(i).second)
+            return QString("at %1 ms: expected \"%2\", actual \"%3\"")
+                    .arg(t)
+                    .arg(QString::fromUtf8(expRuns.at(i).second), QString::fromUtf8(actRuns.at(i).second));
+
+        if (expRuns.at(i).first != actRuns.at(i).first)
+            return QString("at %1 ms: \"%2\" shown for %3 ms, expected %4 ms")
+                    .arg(t)
+                    .arg(QString::fromUtf8(actRuns.at(i).second))
+                    .arg(actRuns.at(i).first)
+                    .arg(expRuns.at(i).first);
+
+        t += expRuns.at(i).first;
+    }
+
+    return QString("runs: expected %1, actual %2").arg(expRuns.count()).arg(actRuns.count());
+}
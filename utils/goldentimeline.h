@@ -0,0 +1,45 @@
+#ifndef GOLDENTIMELINE_H
+#define GOLDENTIMELINE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QJsonObject>
+#include <goldencorpus.h>
+
+class DisplayModel;
+
+/**
+ * Regression check of the emulated display against stored (golden) timelines.
+ *
+ * Each pattern is encoded and shown on a DisplayModel in virtual time for
+ * its text interval. The resulting timeline is run length encoded, one line
+ * per pattern:
+ *
+ *   <cmd> <id> <tone> <multiple text> <ms>"<text>" <ms>"<text>" ...
+ *
+ * e.g. 28 7 40 - 500"Ruf 01" 500"    01" ... where a run is the time a text
+ * is shown. Quotes and backslashes in texts are escaped with a backslash.
+ */
+class GoldenTimeline
+{
+public:
+    GoldenTimeline(const QJsonObject &configOptions, const QJsonObject &test, const TestPatternGenerator &rules);
+
+    bool write(const QString &dir);
+    int check(const QString &dir, int maxReports = 10);
+
+    static QByteArray render(const QByteArray &protocol, int duration);
+    static QString describeDiff(const QByteArray &expected, const QByteArray &actual);
+
+private:
+    QList<GoldenCorpus::sVariant> mVariants;
+    QJsonObject mTest;
+    const TestPatternGenerator &mRules;
+
+    QList<QByteArray> renderVariant(const GoldenCorpus::sVariant &variant) const;
+
+    static void appendRun(QByteArray &timeline, qint64 duration, const QString &text);
+    static QList<QPair<qint64, QByteArray> > parseRuns(const QByteArray &line, QByteArray &prefix);
+};
+
+#endif // GOLDENTIMELINE_H
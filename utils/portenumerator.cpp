@@ -0,0 +1,138 @@
+#include "portenumerator.h"
+#include <QDebug>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <QSocketNotifier>
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <string.h>
+#include <unistd.h>
+#endif
+
+static QList<QSerialPortInfo> enumeratePorts()
+{
+    QElapsedTimer elapsed;
+
+    elapsed.start();
+    QList<QSerialPortInfo> ports = QSerialPortInfo::availablePorts();
+    qDebug() << ports.count() << "serial ports enumerated in" << elapsed.elapsed() << "ms";
+
+    return ports;
+}
+
+PortEnumerator::PortEnumerator(QObject *parent) :
+    QObject(parent)
+{
+    mIsReady = false;
+    mIsPending = false;
+    mSocket = -1;
+    mNotifier = 0;
+
+    connect(&mWatcher, SIGNAL(finished()), this, SLOT(onFinished()));
+    connect(&mSettleTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+
+PortEnumerator::~PortEnumerator()
+{
+#ifdef Q_OS_LINUX
+    if (mSocket >= 0)
+        ::close(mSocket);
+#endif
+}
+
+PortEnumerator *PortEnumerator::instance()
+{
+    static PortEnumerator *enumerator = new PortEnumerator(qApp);    // deleted with the application
+    return enumerator;
+}
+
+QStringList PortEnumerator::portNames() const
+{
+    QStringList names;
+
+    foreach (const QSerialPortInfo &info, mPorts)
+        names << info.portName();
+
+    return names;
+}
+
+// enumerate the ports in background, portsChanged() is emitted when done
+void PortEnumerator::refresh()
+{
+    if (mWatcher.isRunning())
+    {
+        mIsPending = true;
+        return;
+    }
+
+    mIsPending = false;
+    mWatcher.setFuture(QtConcurrent::run(enumeratePorts));
+}
+
+// refresh the ports on hot-plug of serial adapters
+void PortEnumerator::watch()
+{
+    if (isWatching())
+        return;
+
+#ifdef Q_OS_LINUX
+    struct sockaddr_nl addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1;     // kernel uevents
+
+    mSocket = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_KOBJECT_UEVENT);
+
+    if ((mSocket >= 0) && (bind(mSocket, (struct sockaddr *)&addr, sizeof(addr)) < 0))
+    {
+        ::close(mSocket);
+        mSocket = -1;
+    }
+
+    if (mSocket >= 0)
+    {
+        mNotifier = new QSocketNotifier(mSocket, QSocketNotifier::Read, this);
+        connect(mNotifier, SIGNAL(activated(int)), this, SLOT(onUevent()));
+
+        mSettleTimer.setSingleShot(true);
+        mSettleTimer.setInterval(SETTLE_TIME);
+        qDebug() << "serial ports: watching uevents";
+        return;
+    }
+
+    qWarning() << "serial ports: no uevents, polling";
+#endif
+
+    mSettleTimer.setSingleShot(false);
+    mSettleTimer.start(POLL_PERIOD);
+}
+
+// uevent of the kernel, e.g. "add@/devices/.../tty/ttyUSB0" followed by "SUBSYSTEM=tty"
+void PortEnumerator::onUevent()
+{
+#ifdef Q_OS_LINUX
+    char buffer[4096];
+    ssize_t length;
+
+    while ((length = recv(mSocket, buffer, sizeof(buffer), 0)) > 0)
+    {
+        QList<QByteArray> fields = QByteArray(buffer, length).split('\0');
+
+        if (fields.contains("SUBSYSTEM=tty") && (fields.contains("ACTION=add") || fields.contains("ACTION=remove")))
+            mSettleTimer.start();
+    }
+#endif
+}
+
+void PortEnumerator::onFinished()
+{
+    mPorts = mWatcher.result();
+    mIsReady = true;
+    emit portsChanged();
+
+    if (mIsPending)
+        refresh();
+}
@@ -0,0 +1,64 @@
+#ifndef PORTENUMERATOR_H
+#define PORTENUMERATOR_H
+
+#include <QObject>
+#include <QList>
+#include <QStringList>
+#include <QFutureWatcher>
+#include <QSerialPortInfo>
+#include <QTimer>
+
+class QSocketNotifier;
+
+/**
+ * Cached list of the serial ports of the host.
+ *
+ * Enumerating the ports may take seconds on hosts with many (virtual) ports,
+ * so the ports are enumerated in a worker thread and the result is cached.
+ * The cache is shared by the application, the last list is available at once
+ * while a refresh is running.
+ *
+ * When watching, the list is refreshed on hot-plug: on Linux on the uevents
+ * of the tty subsystem (netlink socket), else by polling.
+ */
+class PortEnumerator : public QObject
+{
+    Q_OBJECT
+public:
+    static PortEnumerator *instance();
+    ~PortEnumerator();
+
+    bool isReady() const { return mIsReady; }
+    bool isRunning() const { return mWatcher.isRunning(); }
+    QList<QSerialPortInfo> ports() const { return mPorts; }
+    QStringList portNames() const;
+
+    void watch();
+    bool isWatching() const { return mNotifier || mSettleTimer.isActive(); }
+
+signals:
+    void portsChanged();
+
+public slots:
+    void refresh();
+
+private slots:
+    void onFinished();
+    void onUevent();
+
+private:
+    explicit PortEnumerator(QObject *parent = 0);
+
+    QFutureWatcher<QList<QSerialPortInfo> > mWatcher;
+    QList<QSerialPortInfo> mPorts;
+    bool mIsReady;          // ports enumerated at least once
+    bool mIsPending;        // refresh requested while running
+    int mSocket;            // netlink socket of the uevents, -1: polling
+    QSocketNotifier *mNotifier;
+    QTimer mSettleTimer;    // refresh after a burst of uevents, or polling period
+
+    static const int SETTLE_TIME = 500;     // ms, device node is created after the uevent
+    static const int POLL_PERIOD = 2000;    // ms
+};
+
+#endif // PORTENUMERATOR_H
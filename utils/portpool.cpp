@@ -0,0 +1,127 @@
+#include "portpool.h"
+#include <QDebug>
+#include <QSet>
+#include <fd.h>
+#include <testlink.h>
+#include <testmanager.h>
+#include <portenumerator.h>
+
+using namespace fd;
+
+PortPool::PortPool(const QJsonObject &config, const QJsonObject &test, const TestPatternGenerator *rules, QObject *parent) :
+    QObject(parent)
+{
+    mConfig = config;
+    mTest = test;
+    mRules = rules;
+    mIsRunning = false;
+
+    connect(PortEnumerator::instance(), SIGNAL(portsChanged()), this, SLOT(onPortsChanged()));
+}
+
+PortPool::~PortPool()
+{
+    stop();
+}
+
+void PortPool::start()
+{
+    mIsRunning = true;
+
+    PortEnumerator::instance()->watch();
+    PortEnumerator::instance()->refresh();
+}
+
+void PortPool::stop()
+{
+    mIsRunning = false;
+
+    foreach (const QString &port, mPipelines.keys())
+        detach(port);
+}
+
+bool PortPool::isMatching(const QString &serialNumber) const
+{
+    return mSerialNumbers.contains("*") || (!serialNumber.isEmpty() && mSerialNumbers.contains(serialNumber));
+}
+
+void PortPool::onPortsChanged()
+{
+    if (!mIsRunning)
+        return;
+
+    QSet<QString> present;
+
+    foreach (const QSerialPortInfo &info, PortEnumerator::instance()->ports())
+    {
+        present << info.portName();
+
+        if (!mPipelines.contains(info.portName()) && isMatching(info.serialNumber()))
+            attach(info.portName(), info.serialNumber());
+    }
+
+    foreach (const QString &port, mPipelines.keys())
+    {
+        if (!present.contains(port))
+            detach(port);
+    }
+}
+
+// adapter removed while open, the uevent may follow later
+void PortPool::onPortError(QSerialPort::SerialPortError error)
+{
+    QSerialPort *serialPort = qobject_cast<QSerialPort *>(sender());
+
+    if (!serialPort || (error != QSerialPort::ResourceError) || !mPipelines.contains(serialPort->portName()))
+        return;
+
+    detach(serialPort->portName());
+}
+
+void PortPool::attach(const QString &port, const QString &serialNumber)
+{
+    QJsonObject config = mConfig;
+    QJsonObject hostInterface = config[HostInterfaceSection].toObject();
+    sPipeline pipeline;
+
+    hostInterface[ConfigName] = port;
+    config[HostInterfaceSection] = hostInterface;
+
+    pipeline.serialNumber = serialNumber;
+    pipeline.link = new TestLink;
+
+    if (pipeline.link->open(config, false))     // e.g. port in use, retried on the next hot-plug
+    {
+        delete pipeline.link;
+        return;
+    }
+
+    pipeline.testManager = new TestManager(pipeline.link->serialProtocol(), config, mTest, mRules);
+    connect(pipeline.link->serialPort(), SIGNAL(errorOccurred(QSerialPort::SerialPortError)),
+            this, SLOT(onPortError(QSerialPort::SerialPortError)));
+
+    mPipelines.insert(port, pipeline);
+    pipeline.testManager->start();
+
+    qDebug().noquote() << QString("%1: attached adapter %2").arg(port, serialNumber);
+    emit attached(port, serialNumber);
+}
+
+// the adapter is gone, the test is not stopped on the display
+void PortPool::detach(const QString &port)
+{
+    if (!mPipelines.contains(port))
+        return;
+
+    sPipeline pipeline = mPipelines.take(port);
+
+    disconnect(pipeline.link->serialPort(), 0, this, 0);
+    pipeline.link->serialPort()->close();
+
+    // may be called from a signal of the pipeline, deleted when back in the event loop
+    pipeline.testManager->deleteLater();
+    pipeline.link->deleteLater();
+
+    qDebug().noquote() << QString("%1: detached adapter %2").arg(port, pipeline.serialNumber);
+    emit detached(port);
+}
@@ -0,0 +1,65 @@
+#ifndef PORTPOOL_H
+#define PORTPOOL_H
+
+#include <QObject>
+#include <QMap>
+#include <QStringList>
+#include <QJsonObject>
+#include <QSerialPort>
+#include <testpatterngenerator.h>
+
+class TestLink;
+class TestManager;
+
+/**
+ * Pool of the serial adapters of a test bench.
+ *
+ * The serial ports are watched for hot-plug. A test pipeline (link to the
+ * display, serial protocol and test manager running the test cycle) is
+ * attached to each plugged adapter with a configured serial number and torn
+ * down when the adapter is removed. The pipelines share the configuration,
+ * only the host interface name differs.
+ */
+class PortPool : public QObject
+{
+    Q_OBJECT
+public:
+    PortPool(const QJsonObject &config, const QJsonObject &test, const TestPatternGenerator *rules, QObject *parent = 0);
+    ~PortPool();
+
+    void setSerialNumbers(const QStringList &serialNumbers) { mSerialNumbers = serialNumbers; }   // "*": any adapter
+
+    void start();
+    void stop();
+
+    int count() const { return mPipelines.count(); }
+    QStringList ports() const { return mPipelines.keys(); }
+
+signals:
+    void attached(QString port, QString serialNumber);
+    void detached(QString port);
+
+private slots:
+    void onPortsChanged();
+    void onPortError(QSerialPort::SerialPortError error);
+
+private:
+    struct sPipeline {
+        QString serialNumber;
+        TestLink *link;
+        TestManager *testManager;
+    };
+
+    QJsonObject mConfig;
+    QJsonObject mTest;
+    const TestPatternGenerator *mRules;
+    QStringList mSerialNumbers;
+    QMap<QString, sPipeline> mPipelines;    // attached pipelines by port name
+    bool mIsRunning;
+
+    bool isMatching(const QString &serialNumber) const;
+    void attach(const QString &port, const QString &serialNumber);
+    void detach(const QString &port);
+};
+
+#endif // PORTPOOL_H
@@ -0,0 +1,200 @@
+#include "portprober.h"
+#include <QDebug>
+#include <QSerialPort>
+#include <QJsonObject>
+#include <fd.h>
+#include <serialprotocol.h>
+#include <testmanager.h>
+
+using namespace fd;
+
+PortProber::PortProber(QObject *parent) :
+    QObject(parent)
+{
+    mResponseTimeout = 300;
+    mRetries = 1;
+}
+
+PortProber::~PortProber()
+{
+    stop();
+}
+
+// empty text at lowest priority, leaves the display as it is
+QByteArray PortProber::probeFrame(bool isSeriobus)
+{
+    QByteArray protocol = TestManager::makeLrProtocolHeader(LR_CMD_28);
+
+    protocol[PROT_28_TXT_FORMAT] = ALIGN_LEFT;
+    protocol[PROT_28_PRIORITY] = PRTY_LOWEST;
+    protocol.append(char(0));       // checksum of the empty payload
+
+    if (isSeriobus)
+        protocol.prepend('W');
+
+    return SerialProtocol::frame(protocol);
+}
+
+void PortProber::start(const QStringList &ports)
+{
+    stop();
+    mResults.clear();
+
+    foreach (const QString &port, ports)
+    {
+        sProbe *probe = new sProbe;
+
+        probe->port = port;
+        probe->serialPort = new QSerialPort(port);
+        probe->serialProtocol = new SerialProtocol;
+        probe->timer = new ClockTimer;
+        probe->candidate = -1;
+        probe->retry = 0;
+
+        probe->timer->setSingleShot(true);
+        probe->timer->setInterval(mResponseTimeout);
+
+        connect(probe->timer, SIGNAL(timeout()), this, SLOT(onResponseTimeout()));
+        connect(probe->serialProtocol, SIGNAL(receivedACK()), this, SLOT(onReceivedACK()));
+        connect(probe->serialProtocol, SIGNAL(receivedNACK()), this, SLOT(onReceivedNACK()));
+
+        mProbes.append(probe);
+    }
+
+    qDebug() << "probing" << ports.count() << "ports with" << mInterfaces.count() << "interfaces";
+
+    foreach (sProbe *probe, QList<sProbe *>(mProbes))
+        probeNext(probe);
+
+    if (ports.isEmpty())        // otherwise remove() emits it with the last probe
+        emit finished();
+}
+
+void PortProber::stop()
+{
+    while (!mProbes.isEmpty())
+        release(mProbes.takeFirst());
+}
+
+PortProber::sProbe *PortProber::probeOf(QObject *object) const
+{
+    foreach (sProbe *probe, mProbes)
+    {
+        if ((probe->serialProtocol == object) || (probe->timer == object))
+            return probe;
+    }
+
+    return 0;
+}
+
+// open the port with the next candidate interface, remove the probe after the last one
+void PortProber::probeNext(sProbe *probe)
+{
+    probe->serialProtocol->setDevice(0);
+    probe->serialPort->close();
+
+    while (++probe->candidate < mInterfaces.count())
+    {
+        QStringList serialParams = mInterfaces.at(probe->candidate).toObject()[ConfigParam].toString().split(",");
+
+        if (serialParams.count() != 4)
+            continue;
+
+        probe->serialPort->setBaudRate(serialParams.at(0).toInt());
+        probe->serialPort->setParity(serialParams.at(1) == "o" ? QSerialPort::OddParity :
+                                     serialParams.at(1) == "e" ? QSerialPort::EvenParity : QSerialPort::NoParity);
+        probe->serialPort->setDataBits((QSerialPort::DataBits)serialParams.at(2).toInt());
+        probe->serialPort->setStopBits((QSerialPort::StopBits)serialParams.at(3).toInt());
+
+        if (!probe->serialPort->open(QIODevice::ReadWrite))
+        {
+            qDebug() << "cannot open" << probe->port << probe->serialPort->errorString();
+            break;      // port busy or missing, other candidates fail as well
+        }
+
+        probe->serialProtocol->setDevice(probe->serialPort);
+        probe->serialProtocol->setSerialFormat(serialParams.at(0).toInt(), serialParams.at(2).toInt(),
+                                               serialParams.at(1) != "n", serialParams.at(3).toInt());
+        probe->retry = 0;
+
+        send(probe);
+        return;
+    }
+
+    remove(probe);
+}
+
+void PortProber::send(sProbe *probe)
+{
+    QString name = mInterfaces.at(probe->candidate).toObject()[ConfigName].toString();
+
+    probe->serialProtocol->sendFrame(probeFrame(name.contains("Seriobus")));
+    probe->timer->start();
+}
+
+void PortProber::answered(sProbe *probe, bool isAck)
+{
+    QJsonObject candidate = mInterfaces.at(probe->candidate).toObject();
+    sResult result;
+
+    result.port = probe->port;
+    result.interfaceName = candidate[ConfigName].toString();
+    result.param = candidate[ConfigParam].toString();
+    result.isAck = isAck;
+
+    mResults.append(result);
+    qDebug() << "display on" << result.port << result.interfaceName << result.param << (isAck ? "ACK" : "NACK");
+
+    emit detected(result);
+    remove(probe);      // one display per port
+}
+
+void PortProber::remove(sProbe *probe)
+{
+    mProbes.removeOne(probe);
+    release(probe);
+
+    if (mProbes.isEmpty())
+        emit finished();
+}
+
+void PortProber::release(sProbe *probe)
+{
+    probe->timer->stop();
+    probe->serialProtocol->setDevice(0);
+    probe->serialPort->close();
+
+    probe->timer->deleteLater();
+    probe->serialProtocol->deleteLater();
+    probe->serialPort->deleteLater();
+    delete probe;
+}
+
+void PortProber::onReceivedACK()
+{
+    sProbe *probe = probeOf(sender());
+
+    if (probe && probe->timer->isActive())
+        answered(probe, true);
+}
+
+void PortProber::onReceivedNACK()
+{
+    sProbe *probe = probeOf(sender());
+
+    if (probe && probe->timer->isActive())
+        answered(probe, false);
+}
+
+void PortProber::onResponseTimeout()
+{
+    sProbe *probe = probeOf(sender());
+
+    if (!probe)
+        return;
+
+    if (probe->retry++ < mRetries)
+        send(probe);
+    else
+        probeNext(probe);
+}
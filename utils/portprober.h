@@ -0,0 +1,82 @@
+#ifndef PORTPROBER_H
+#define PORTPROBER_H
+
+#include <QObject>
+#include <QList>
+#include <QStringList>
+#include <QJsonArray>
+#include <clock.h>
+
+class QSerialPort;
+class SerialProtocol;
+
+/**
+ * Detection of the serial ports with a responding Flurdisplay.
+ *
+ * All ports are probed at the same time (the serial ports work without
+ * blocking), each with the candidate device interfaces one after the other,
+ * e.g. RS485 38400,n,8,2 and Seriobus 19200,n,8,1. A candidate is probed with
+ * an empty text of protocol 0x28 at the lowest priority; a port on which the
+ * display answers (ACK or NACK) is reported with the interface.
+ */
+class PortProber : public QObject
+{
+    Q_OBJECT
+public:
+    struct sResult {
+        QString port;
+        QString interfaceName;
+        QString param;
+        bool isAck;             // false: display answered NACK
+    };
+
+    explicit PortProber(QObject *parent = 0);
+    ~PortProber();
+
+    void setInterfaces(const QJsonArray &interfaces) { mInterfaces = interfaces; }   // devInterface section
+    void setResponseTimeout(int msec) { mResponseTimeout = msec; }
+    void setRetries(int retries) { mRetries = retries; }
+
+    bool isRunning() const { return !mProbes.isEmpty(); }
+    const QList<sResult> &results() const { return mResults; }
+
+    static QByteArray probeFrame(bool isSeriobus);
+
+signals:
+    void detected(const PortProber::sResult &result);
+    void finished();
+
+public slots:
+    void start(const QStringList &ports);
+    void stop();
+
+private slots:
+    void onReceivedACK();
+    void onReceivedNACK();
+    void onResponseTimeout();
+
+private:
+    struct sProbe {
+        QString port;
+        QSerialPort *serialPort;
+        SerialProtocol *serialProtocol;
+        ClockTimer *timer;
+        int candidate;          // index in mInterfaces
+        int retry;
+    };
+
+    QJsonArray mInterfaces;
+    QList<sProbe *> mProbes;
+    QList<sResult> mResults;
+    int mResponseTimeout;
+    int mRetries;
+
+    sProbe *probeOf(QObject *object) const;
+    void probeNext(sProbe *probe);
+    void send(sProbe *probe);
+    void answered(sProbe *probe, bool isAck);
+    void remove(sProbe *probe);
+    void release(sProbe *probe);
+};
+
+#endif // PORTPROBER_H
@@ -0,0 +1,141 @@
+#include "priorityindex.h"
+#include <algorithm>
+
+PriorityIndex::PriorityIndex()
+{
+    mIsOrderValid = true;
+}
+
+void PriorityIndex::clear()
+{
+    mRuns.clear();
+    mCount.clear();
+    mCountAll.clear();
+    mCountAddr.clear();
+    mOrder.clear();
+    mPos.clear();
+    mIsOrderValid = true;
+}
+
+void PriorityIndex::insert(int key, int prio, quint64 firstId, quint64 count, const QVector<sAddrRange> &addrList)
+{
+    remove(key);
+
+    sRun run;
+    run.prio = prio;
+    run.firstId = firstId;
+    run.count = count;
+    run.addrList = addrList;
+
+    updateCount(run, 1);
+    mRuns.insert(key, run);
+    mIsOrderValid = false;
+}
+
+// run is only ordered, its patterns are counted by the caller
+void PriorityIndex::insertOrdered(int key, int prio, quint64 firstId)
+{
+    insert(key, prio, firstId, 0, QVector<sAddrRange>());
+}
+
+void PriorityIndex::remove(int key)
+{
+    if (!mRuns.contains(key))
+        return;
+
+    updateCount(mRuns.value(key), -1);
+    mRuns.remove(key);
+    mIsOrderValid = false;
+}
+
+// number of patterns with given priority shown on the display with given address
+quint64 PriorityIndex::countOnDisplay(int prio, quint16 addr) const
+{
+    quint64 cnt = mCountAll.value(prio);
+
+    if (mCountAddr.contains(prio))
+    {
+        const QHash<quint16, quint64> &countAddr = mCountAddr[prio];
+
+        cnt += countAddr.value(addr);
+
+        if (addr & 0xFF)
+            cnt += countAddr.value(addr & 0xFF00);  // patterns to all rooms of the station
+    }
+
+    return cnt;
+}
+
+// return key of the 1st run, -1 if index is empty
+int PriorityIndex::first() const
+{
+    updateOrder();
+    return mOrder.isEmpty() ? -1 : mOrder.first();
+}
+
+// return key of the last run, -1 if index is empty
+int PriorityIndex::last() const
+{
+    updateOrder();
+    return mOrder.isEmpty() ? -1 : mOrder.last();
+}
+
+// return key of the run next to given one, -1 if there is no next run
+int PriorityIndex::next(int key) const
+{
+    updateOrder();
+
+    int pos = mPos.value(key, -1);
+
+    if ((pos < 0) || (pos + 1 >= mOrder.count()))
+        return -1;
+
+    return mOrder.at(pos + 1);
+}
+
+void PriorityIndex::updateCount(const sRun &run, int sign)
+{
+    if (!run.count)
+        return;
+
+    mCount[run.prio] += sign * run.count;
+
+    if (run.addrList.isEmpty())
+    {
+        mCountAll[run.prio] += sign * run.count;
+    }
+    else
+    {
+        QHash<quint16, quint64> &countAddr = mCountAddr[run.prio];
+
+        foreach (const sAddrRange &range, run.addrList)
+        {
+            for (int i = 0; i < range.count; ++i)
+                countAddr[range.first + i * range.step] += sign;
+        }
+    }
+}
+
+void PriorityIndex::updateOrder() const
+{
+    if (mIsOrderValid)
+        return;
+
+    QVector<QPair<QPair<int, quint64>, int> > order;
+
+    for (QMap<int, sRun>::ConstIterator itr = mRuns.constBegin(); itr != mRuns.constEnd(); ++itr)
+        order.append(qMakePair(qMakePair(-itr.value().prio, itr.value().firstId), itr.key()));
+
+    std::sort(order.begin(), order.end());
+
+    mOrder.clear();
+    mPos.clear();
+
+    for (int i = 0; i < order.count(); ++i)
+    {
+        mOrder.append(order.at(i).second);
+        mPos[order.at(i).second] = i;
+    }
+
+    mIsOrderValid = true;
+}
@@ -0,0 +1,64 @@
+#ifndef PRIORITYINDEX_H
+#define PRIORITYINDEX_H
+
+#include <QHash>
+#include <QMap>
+#include <QVector>
+#include <limits.h>
+
+// sequence of LR-addresses: first, first + step, ... (address = station << 8 | room)
+struct sAddrRange {
+    quint16 first;
+    quint16 step;
+    quint16 count;
+};
+
+/**
+ * Index of the test patterns by priority.
+ *
+ * Patterns are inserted as runs (patterns of a rule) with consecutive ids and
+ * equal priority. The index keeps the number of patterns per priority and
+ * per display address, and the order of the runs by priority (highest first)
+ * then by id. Runs can be inserted and removed incrementally.
+ */
+class PriorityIndex
+{
+public:
+    static const int CoverageKey = INT_MAX;    // key of the run of generated coverage patterns
+
+    PriorityIndex();
+
+    void clear();
+    void insert(int key, int prio, quint64 firstId, quint64 count, const QVector<sAddrRange> &addrList);
+    void insertOrdered(int key, int prio, quint64 firstId);
+    void remove(int key);
+
+    quint64 count(int prio) const { return mCount.value(prio); }
+    quint64 countOnDisplay(int prio, quint16 addr) const;
+
+    int first() const;
+    int last() const;
+    int next(int key) const;
+
+private:
+    struct sRun {
+        int prio;
+        quint64 firstId;
+        quint64 count;      // 0: run is ordered, but not counted
+        QVector<sAddrRange> addrList;
+    };
+
+    QMap<int, sRun> mRuns;
+    QHash<int, quint64> mCount;         // patterns per priority
+    QHash<int, quint64> mCountAll;      // patterns to all displays per priority
+    QHash<int, QHash<quint16, quint64> > mCountAddr;   // patterns per priority and address
+
+    mutable QVector<int> mOrder;        // run keys ordered by priority, id
+    mutable QHash<int, int> mPos;       // position of run key in mOrder
+    mutable bool mIsOrderValid;
+
+    void updateCount(const sRun &run, int sign);
+    void updateOrder() const;
+};
+
+#endif // PRIORITYINDEX_H
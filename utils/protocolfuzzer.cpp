@@ -0,0 +1,333 @@
+#include "protocolfuzzer.h"
+#include <QDebug>
+#include <fd.h>
+#include <frameencoder.h>
+#include <testmanager.h>
+#include <serialprotocol.h>
+
+using namespace fd;
+
+enum { ResponseAck, ResponseNack, ResponseNone };
+
+ProtocolFuzzer::ProtocolFuzzer(TestManager *testManager, SerialProtocol *serialProtocol, quint64 seed, QObject *parent) :
+    QObject(parent), mRandom(seed)
+{
+    mTestManager = testManager;
+    mSerialProtocol = serialProtocol;
+    mClock = Clock::system();
+    mIsSeriobus = false;
+    mIsRunning = false;
+    mState = StateIdle;
+    mEnd = 0;
+    mIncident = 0;
+    mMaxRecovery = 60000;
+    mMutation = MutationLength;
+    mIsProbeRepeated = false;
+    mCntSent = 0;
+    mCntResponses[ResponseAck] = mCntResponses[ResponseNack] = mCntResponses[ResponseNone] = 0;
+    mCntFindings = 0;
+
+    mResponseTimer.setSingleShot(true);
+    mResponseTimer.setInterval(200);
+
+    connect(&mResponseTimer, SIGNAL(timeout()), this, SLOT(onResponseTimeout()));
+    connect(mSerialProtocol, SIGNAL(receivedACK()), this, SLOT(onReceivedACK()));
+    connect(mSerialProtocol, SIGNAL(receivedNACK()), this, SLOT(onReceivedNACK()));
+    connect(mSerialProtocol, SIGNAL(receivedEOT()), this, SLOT(onReceivedEOT()));
+}
+
+void ProtocolFuzzer::setClock(Clock *clock)
+{
+    mClock = clock ? clock : Clock::system();
+    mResponseTimer.setClock(clock);
+}
+
+// return true on errors
+bool ProtocolFuzzer::setLogFile(const QString &fileName)
+{
+    mLog.setFileName(fileName);
+
+    if (!mLog.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        qWarning() << "cannot create fuzzer log" << fileName;
+        return true;
+    }
+
+    mLog.write("time_ms,finding,mutation,recovery_ms,frame_hex\n");
+    return false;
+}
+
+const char *ProtocolFuzzer::mutationName(Mutation mutation)
+{
+    static const char *names[MutationCount] = {
+        "length", "checksum", "oversize", "bits", "truncate", "strayControl"
+    };
+
+    return (mutation < MutationCount) ? names[mutation] : "?";
+}
+
+// return frame of the mutated protocol (field mutations apply to 0x28 only)
+QByteArray ProtocolFuzzer::mutate(const QByteArray &protocol, Mutation mutation, bool isSeriobus, XorShift &random)
+{
+    QByteArray mutated = protocol;
+    bool is28 = (protocol.length() > PROT_28_PL_DATA) && ((uchar)protocol.at(PROT_HDR_CMD) == LR_CMD_28);
+
+    if (is28)
+    {
+        switch (mutation)
+        {
+        case MutationLength:
+            mutated[PROT_28_PL_LENGTH] = mutated.at(PROT_28_PL_LENGTH) + 1 + random.bounded(255);
+            break;
+
+        case MutationChecksum:
+            mutated[mutated.length() - 1] = mutated.at(mutated.length() - 1) ^ (1 + random.bounded(255));
+            break;
+
+        case MutationOversize:
+        {
+            QByteArray payload(1 + random.bounded(255), 0);
+
+            for (int i = 0; i < payload.length(); ++i)
+                payload[i] = 0x20 + random.bounded(0x60);
+
+            payload.prepend(mutated.mid(PROT_28_PL_DATA, (uchar)mutated.at(PROT_28_PL_LENGTH)));
+            mutated = mutated.left(PROT_28_PL_DATA) + payload;
+            mutated[PROT_28_PL_LENGTH] = payload.length();      // truncated to 8 bits
+            mutated.append(FrameEncoder::checksum(payload.constData(), payload.length()));
+            break;
+        }
+
+        case MutationBits:
+        {
+            static const uchar fields[] = { PROT_28_TXT_FORMAT, PROT_28_TONE, PROT_28_TXT_COLOR, PROT_28_DEV_TYPE };
+            uchar field = fields[random.bounded(sizeof(fields))];
+
+            mutated[field] = mutated.at(field) | (1 << random.bounded(8));
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+
+    if (isSeriobus)
+        mutated.prepend('W');
+
+    QByteArray frame = SerialProtocol::frame(mutated);
+
+    if (mutation == MutationTruncate)
+    {
+        frame.truncate(1 + random.bounded(frame.length() - 1));     // ETX is always cut
+    }
+    else if (mutation == MutationStrayControl)
+    {
+        char c = random.bounded(2) ? SerialProtocol::STX : SerialProtocol::ETX;
+
+        frame.insert(1 + random.bounded(frame.length() - 2), c);
+    }
+
+    return frame;
+}
+
+void ProtocolFuzzer::start(qint64 duration)
+{
+    mCommands = mTestManager->commands();
+    mIsSeriobus = mTestManager->isSeriobus();
+
+    if (mCommands.isEmpty() || mTestManager->testPatterns().isEmpty())
+    {
+        qWarning() << "fuzzer: no commands or test patterns";
+        emit finished();
+        return;
+    }
+
+    mIsRunning = true;
+    mEnd = mClock->now() + duration;
+    mCntSent = 0;
+    mCntResponses[ResponseAck] = mCntResponses[ResponseNack] = mCntResponses[ResponseNone] = 0;
+    mCntFindings = 0;
+
+    next();
+}
+
+void ProtocolFuzzer::stop()
+{
+    if (!mIsRunning)
+        return;
+
+    mIsRunning = false;
+    mState = StateIdle;
+    mResponseTimer.stop();
+
+    qDebug() << "fuzzer:" << mCntSent << "mutated frames," << mCntResponses[ResponseAck] << "ack,"
+             << mCntResponses[ResponseNack] << "nack," << mCntResponses[ResponseNone] << "no response,"
+             << mCntFindings << "findings";
+
+    emit finished();
+}
+
+// send the next mutated frame
+void ProtocolFuzzer::next()
+{
+    if (mClock->now() >= mEnd)
+    {
+        stop();
+        return;
+    }
+
+    const TestPatternGenerator &testPatterns = mTestManager->testPatterns();
+    sTestPattern testPattern = testPatterns.at(mRandom.bounded(testPatterns.count()) + 1);
+    uchar cmd = mCommands.at(mRandom.bounded(mCommands.count()));
+    QByteArray protocol = mTestManager->encodeLrProtocol(testPattern, TestManager::makeLrProtocolHeader(cmd), true);
+
+    if (protocol.isEmpty())
+        protocol = mTestManager->encodeLrProtocol(testPattern, TestManager::makeLrProtocolHeader(LR_CMD_28), true);
+
+    mMutation = Mutation(mRandom.bounded(MutationCount));
+    mMutatedFrame = mutate(protocol, mMutation, mIsSeriobus, mRandom);
+    mProbeFrame = SerialProtocol::frame(mIsSeriobus ? 'W' + protocol : protocol);
+
+    mSerialProtocol->sendFrame(mMutatedFrame);
+    ++mCntSent;
+    mIsProbeRepeated = false;
+
+    mState = StateMutated;
+    mResponseTimer.start();
+}
+
+void ProtocolFuzzer::sendProbe(State state)
+{
+    mState = state;
+    mSerialProtocol->sendFrame(mProbeFrame);
+    mResponseTimer.start();
+}
+
+// hang or reset detected, send valid frame until the device recovers
+void ProtocolFuzzer::recover(const char *kind)
+{
+    mIncident = mClock->now();
+    report(kind, -1);
+    sendProbe(StateRecover);
+}
+
+void ProtocolFuzzer::report(const char *kind, qint64 recovery)
+{
+    QString line = QString("%1,%2,%3,%4,%5")
+            .arg(mClock->now())
+            .arg(kind)
+            .arg(mutationName(mMutation))
+            .arg(recovery)
+            .arg(QString::fromLatin1(mMutatedFrame.toHex()));
+
+    if (qstrcmp(kind, "recovered"))
+        ++mCntFindings;
+
+    if (mLog.isOpen())
+    {
+        mLog.write(line.toLatin1() + "\n");
+        mLog.flush();
+    }
+
+    qWarning().noquote() << "fuzzer:" << line;
+}
+
+void ProtocolFuzzer::onReceivedACK()
+{
+    if (!mIsRunning || !mResponseTimer.isActive())
+        return;
+
+    mResponseTimer.stop();
+
+    switch (mState)
+    {
+    case StateMutated:
+        ++mCntResponses[ResponseAck];
+        sendProbe(StateProbe);
+        break;
+
+    case StateProbe:
+        next();
+        break;
+
+    case StateRecover:
+        report("recovered", mClock->now() - mIncident);
+        next();
+        break;
+
+    default:
+        break;
+    }
+}
+
+void ProtocolFuzzer::onReceivedNACK()
+{
+    if (!mIsRunning || !mResponseTimer.isActive())
+        return;
+
+    mResponseTimer.stop();
+
+    switch (mState)
+    {
+    case StateMutated:
+        ++mCntResponses[ResponseNack];
+        sendProbe(StateProbe);
+        break;
+
+    case StateProbe:
+        if (mIsProbeRepeated)
+            recover("probeRejected");
+        else
+            sendProbe(StateProbe);  // NACK may answer the rest of a split mutated frame
+
+        mIsProbeRepeated = true;
+        break;
+
+    case StateRecover:
+        sendProbe(StateRecover);
+        break;
+
+    default:
+        break;
+    }
+}
+
+void ProtocolFuzzer::onReceivedEOT()
+{
+    if (!mIsRunning || (mState == StateRecover))
+        return;
+
+    mResponseTimer.stop();
+    recover("reset");
+}
+
+void ProtocolFuzzer::onResponseTimeout()
+{
+    switch (mState)
+    {
+    case StateMutated:
+        ++mCntResponses[ResponseNone];
+        sendProbe(StateProbe);
+        break;
+
+    case StateProbe:
+        recover("hang");
+        break;
+
+    case StateRecover:
+        if (mClock->now() - mIncident > mMaxRecovery)
+        {
+            report("noRecovery", mClock->now() - mIncident);
+            stop();
+        }
+        else
+        {
+            sendProbe(StateRecover);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
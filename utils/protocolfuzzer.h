@@ -0,0 +1,100 @@
+#ifndef PROTOCOLFUZZER_H
+#define PROTOCOLFUZZER_H
+
+#include <QObject>
+#include <QFile>
+#include <QList>
+#include <clock.h>
+#include <xorshift.h>
+
+class TestManager;
+class SerialProtocol;
+
+/**
+ * Structure aware fuzzer of the LR protocols.
+ *
+ * A valid frame of a random pattern and command is mutated at field level
+ * (payload length, checksum, oversized payload, format/tone/color bits of
+ * 0x28) or at frame level (truncated frame, STX/ETX inside the hex data)
+ * and sent, followed by the valid frame as probe. A probe without ACK is a
+ * hang, an EOT a reset of the device; in both cases the valid frame is sent
+ * repeatedly until the device recovers. Findings are logged with mutation,
+ * recovery time and the triggering frame. Mutations are reproducible from
+ * the seed.
+ */
+class ProtocolFuzzer : public QObject
+{
+    Q_OBJECT
+public:
+    enum Mutation {
+        MutationLength,
+        MutationChecksum,
+        MutationOversize,
+        MutationBits,
+        MutationTruncate,
+        MutationStrayControl,
+        MutationCount
+    };
+
+    ProtocolFuzzer(TestManager *testManager, SerialProtocol *serialProtocol, quint64 seed, QObject *parent = 0);
+
+    void setClock(Clock *clock);
+    void setResponseTimeout(int msec) { mResponseTimer.setInterval(msec); }
+    void setMaxRecovery(int msec) { mMaxRecovery = msec; }
+    bool setLogFile(const QString &fileName);
+
+    bool isRunning() const { return mIsRunning; }
+    int findings() const { return mCntFindings; }
+
+    static QByteArray mutate(const QByteArray &protocol, Mutation mutation, bool isSeriobus, XorShift &random);
+    static const char *mutationName(Mutation mutation);
+
+signals:
+    void finished();
+
+public slots:
+    void start(qint64 duration);
+    void stop();
+
+private slots:
+    void onReceivedACK();
+    void onReceivedNACK();
+    void onReceivedEOT();
+    void onResponseTimeout();
+
+private:
+    enum State {
+        StateIdle,
+        StateMutated,       // mutated frame sent
+        StateProbe,         // valid frame sent after the mutated one
+        StateRecover        // valid frame sent repeatedly after hang or reset
+    };
+
+    TestManager *mTestManager;
+    SerialProtocol *mSerialProtocol;
+    Clock *mClock;
+    ClockTimer mResponseTimer;
+    QFile mLog;
+    XorShift mRandom;
+    QList<uchar> mCommands;
+    bool mIsSeriobus;
+    bool mIsRunning;
+    State mState;
+    qint64 mEnd;
+    qint64 mIncident;           // time of hang or reset
+    int mMaxRecovery;
+    Mutation mMutation;
+    QByteArray mMutatedFrame;
+    QByteArray mProbeFrame;
+    bool mIsProbeRepeated;
+    quint64 mCntSent;
+    quint64 mCntResponses[3];   // ACK, NACK, none to mutated frames
+    int mCntFindings;
+
+    void next();
+    void sendProbe(State state);
+    void recover(const char *kind);
+    void report(const char *kind, qint64 recovery);
+};
+
+#endif // PROTOCOLFUZZER_H
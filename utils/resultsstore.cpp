@@ -0,0 +1,347 @@
+#include "resultsstore.h"
+#include <QDebug>
+#include <QDir>
+#include <QDataStream>
+#include <QStandardPaths>
+#include <QtEndian>
+
+static const quint32 RECORDS_MAGIC = 0x52464446;    // "FDFR"
+static const quint32 INDEX_MAGIC = 0x49464446;      // "FDFI"
+static const quint32 RESULTS_VERSION = 1;
+
+static QDataStream &operator<<(QDataStream &out, const sFrameMetric &frame)
+{
+    return out << frame.time << frame.cmd << frame.response << frame.length << frame.latency;
+}
+
+static QDataStream &operator>>(QDataStream &in, sFrameMetric &frame)
+{
+    return in >> frame.time >> frame.cmd >> frame.response >> frame.length >> frame.latency;
+}
+
+ResultsStore::ResultsStore()
+{
+    mLastTime = 0;
+}
+
+QString ResultsStore::defaultDir()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("results");
+}
+
+// FNV-1a of the UTF-8 text, stable across runs and Qt versions
+quint32 ResultsStore::hash(const QString &text)
+{
+    QByteArray data = text.toUtf8();
+    quint32 h = 2166136261u;
+
+    for (int i = 0; i < data.length(); ++i)
+    {
+        h ^= (uchar)data.at(i);
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+// open for append, write the header of a new file, return true on errors
+bool ResultsStore::openFile(QFile &file, quint32 magic)
+{
+    uchar header[HEADER_SIZE];
+
+    if (!file.open(QIODevice::ReadWrite))
+    {
+        qWarning() << "cannot open results" << file.fileName();
+        return true;
+    }
+
+    if (file.size() == 0)
+    {
+        qToLittleEndian<quint32>(magic, header);
+        qToLittleEndian<quint32>(RESULTS_VERSION, header + 4);
+
+        if (file.write((const char *)header, HEADER_SIZE) != HEADER_SIZE)
+            return true;
+    }
+    else if ((file.read((char *)header, HEADER_SIZE) != HEADER_SIZE) ||
+             (qFromLittleEndian<quint32>(header) != magic) ||
+             (qFromLittleEndian<quint32>(header + 4) != RESULTS_VERSION))
+    {
+        qWarning() << "invalid results" << file.fileName();
+        return true;
+    }
+
+    return false;
+}
+
+// return true on errors
+bool ResultsStore::open(const QString &dir)
+{
+    close();
+
+    if (!QDir().mkpath(dir))
+    {
+        qWarning() << "cannot create results directory" << dir;
+        return true;
+    }
+
+    mRecords.setFileName(QDir(dir).filePath("results.fdr"));
+    mIndex.setFileName(QDir(dir).filePath("results.fdi"));
+
+    if (openFile(mRecords, RECORDS_MAGIC) || openFile(mIndex, INDEX_MAGIC))
+    {
+        close();
+        return true;
+    }
+
+    // drop an index entry not completed, e.g. on power loss
+    qint64 size = HEADER_SIZE + (mIndex.size() - HEADER_SIZE) / INDEX_ENTRY_SIZE * INDEX_ENTRY_SIZE;
+
+    if (size != mIndex.size())
+        mIndex.resize(size);
+
+    if (count())
+    {
+        uchar entry[INDEX_ENTRY_SIZE];
+
+        mIndex.seek(size - INDEX_ENTRY_SIZE);
+        mIndex.read((char *)entry, INDEX_ENTRY_SIZE);
+        mLastTime = qFromLittleEndian<qint64>(entry + 12);
+    }
+
+    return false;
+}
+
+void ResultsStore::close()
+{
+    if (mRecords.isOpen())
+        mRecords.close();
+
+    if (mIndex.isOpen())
+        mIndex.close();
+
+    mLastTime = 0;
+}
+
+quint64 ResultsStore::count() const
+{
+    return mIndex.isOpen() ? (mIndex.size() - HEADER_SIZE) / INDEX_ENTRY_SIZE : 0;
+}
+
+// return true on errors
+bool ResultsStore::append(const sRunResult &run)
+{
+    QByteArray record;
+    QDataStream out(&record, QIODevice::WriteOnly);
+    uchar length[4];
+    uchar entry[INDEX_ENTRY_SIZE];
+
+    if (!isOpen())
+        return true;
+
+    out.setVersion(QDataStream::Qt_5_6);
+    out << run.start << run.duration << run.serial << run.device << run.firmware << run.devInterface
+        << run.port << run.verdict << run.sent << run.ack << run.nack << run.frames;
+
+    // start times are kept ascending for the binary search
+    qint64 time = qMax(run.start.toMSecsSinceEpoch(), mLastTime);
+    qint64 offset = mRecords.size();
+
+    qToLittleEndian<quint32>(record.length(), length);
+
+    memset(entry, 0, INDEX_ENTRY_SIZE);
+    qToLittleEndian<quint64>(offset, entry);
+    qToLittleEndian<quint32>(record.length() + 4, entry + 8);
+    qToLittleEndian<qint64>(time, entry + 12);
+    qToLittleEndian<quint32>(hash(run.serial), entry + 20);
+    qToLittleEndian<quint32>(hash(run.firmware), entry + 24);
+    entry[28] = (run.verdict == "passed");
+
+    // record first, the index refers to complete records only
+    if (!mRecords.seek(offset) || (mRecords.write((const char *)length, 4) != 4) ||
+            (mRecords.write(record) != record.length()) || !mRecords.flush())
+    {
+        qWarning() << "cannot write results" << mRecords.fileName();
+        return true;
+    }
+
+    if (!mIndex.seek(mIndex.size()) || (mIndex.write((const char *)entry, INDEX_ENTRY_SIZE) != INDEX_ENTRY_SIZE) ||
+            !mIndex.flush())
+    {
+        qWarning() << "cannot write results" << mIndex.fileName();
+        return true;
+    }
+
+    mLastTime = time;
+    return false;
+}
+
+// indices of the runs matching the query, in order of start time
+QVector<quint64> ResultsStore::find(const sQuery &query) const
+{
+    QVector<quint64> result;
+    quint64 cnt = count();
+
+    if (!cnt)
+        return result;
+
+    QFile &index = const_cast<QFile &>(mIndex);
+    const uchar *entries = index.map(HEADER_SIZE, cnt * INDEX_ENTRY_SIZE);
+
+    if (!entries)
+    {
+        qWarning() << "cannot map results index" << mIndex.fileName();
+        return result;
+    }
+
+    quint64 first = 0;
+    quint64 last = cnt;
+
+    // binary search of the date range
+    if (query.from.isValid())
+    {
+        qint64 from = query.from.toMSecsSinceEpoch();
+        quint64 hi = cnt;
+
+        while (first < hi)
+        {
+            quint64 mid = (first + hi) / 2;
+
+            if (qFromLittleEndian<qint64>(entries + mid * INDEX_ENTRY_SIZE + 12) < from)
+                first = mid + 1;
+            else
+                hi = mid;
+        }
+    }
+
+    if (query.to.isValid())
+    {
+        qint64 to = query.to.toMSecsSinceEpoch();
+        quint64 lo = first;
+
+        while (lo < last)
+        {
+            quint64 mid = (lo + last) / 2;
+
+            if (qFromLittleEndian<qint64>(entries + mid * INDEX_ENTRY_SIZE + 12) <= to)
+                lo = mid + 1;
+            else
+                last = mid;
+        }
+    }
+
+    quint32 serial = hash(query.serial);
+    quint32 firmware = hash(query.firmware);
+
+    for (quint64 i = first; i < last; ++i)
+    {
+        const uchar *entry = entries + i * INDEX_ENTRY_SIZE;
+
+        if (!query.serial.isEmpty() && (qFromLittleEndian<quint32>(entry + 20) != serial))
+            continue;
+
+        if (!query.firmware.isEmpty() && (qFromLittleEndian<quint32>(entry + 24) != firmware))
+            continue;
+
+        result.append(i);
+    }
+
+    index.unmap(const_cast<uchar *>(entries));
+
+    // hashes may collide, verify the candidates
+    if (!query.serial.isEmpty() || !query.firmware.isEmpty())
+    {
+        QVector<quint64> verified;
+        sRunResult run;
+
+        foreach (quint64 idx, result)
+        {
+            if (!read(idx, run) && (query.serial.isEmpty() || (run.serial == query.serial)) &&
+                    (query.firmware.isEmpty() || (run.firmware == query.firmware)))
+            {
+                verified.append(idx);
+            }
+        }
+
+        result = verified;
+    }
+
+    return result;
+}
+
+// return true on errors
+bool ResultsStore::read(quint64 idx, sRunResult &run) const
+{
+    uchar entry[INDEX_ENTRY_SIZE];
+    QFile &index = const_cast<QFile &>(mIndex);
+    QFile &records = const_cast<QFile &>(mRecords);
+
+    if (idx >= count() || !index.seek(HEADER_SIZE + idx * INDEX_ENTRY_SIZE) ||
+            (index.read((char *)entry, INDEX_ENTRY_SIZE) != INDEX_ENTRY_SIZE))
+    {
+        return true;
+    }
+
+    quint64 offset = qFromLittleEndian<quint64>(entry);
+    quint32 length = qFromLittleEndian<quint32>(entry + 8);
+
+    if ((offset + length > quint64(records.size())) || (length < 4) || !records.seek(offset + 4))
+        return true;
+
+    QByteArray record = records.read(length - 4);
+    QDataStream in(record);
+
+    in.setVersion(QDataStream::Qt_5_6);
+    in >> run.start >> run.duration >> run.serial >> run.device >> run.firmware >> run.devInterface
+       >> run.port >> run.verdict >> run.sent >> run.ack >> run.nack >> run.frames;
+
+    return in.status() != QDataStream::Ok;
+}
+
+// query spec: serial=<serial>,firmware=<firmware>,from=<ISO date>,to=<ISO date>, return true on errors
+bool ResultsStore::parseQuery(const QString &spec, sQuery &query)
+{
+    query = sQuery();
+
+    foreach (const QString &item, spec.split(',', QString::SkipEmptyParts))
+    {
+        QString key = item.section('=', 0, 0).trimmed();
+        QString value = item.section('=', 1).trimmed();
+
+        bool isValid = true;
+
+        if (key == "serial")
+        {
+            query.serial = value;
+        }
+        else if (key == "firmware")
+        {
+            query.firmware = value;
+        }
+        else if (key == "from")
+        {
+            query.from = QDateTime::fromString(value, Qt::ISODate);
+            isValid = query.from.isValid();
+        }
+        else if (key == "to")
+        {
+            query.to = QDateTime::fromString(value, Qt::ISODate);
+            isValid = query.to.isValid();
+
+            if (isValid && !value.contains('T'))    // date only: up to end of the day
+                query.to = query.to.addDays(1).addMSecs(-1);
+        }
+        else
+        {
+            isValid = false;
+        }
+
+        if (!isValid)
+        {
+            qWarning() << "invalid results query" << item;
+            return true;
+        }
+    }
+
+    return false;
+}
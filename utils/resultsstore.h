@@ -0,0 +1,85 @@
+#ifndef RESULTSSTORE_H
+#define RESULTSSTORE_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QDateTime>
+
+// response of the display to a frame
+struct sFrameMetric {
+    qint32 time;        // ms since start of the run
+    uchar cmd;
+    uchar response;     // ACK, NACK, 0: none
+    quint16 length;     // frame length in bytes
+    qint32 latency;     // ms from end of transmission to response, -1: none
+};
+
+// test run of a display unit
+struct sRunResult {
+    QDateTime start;
+    qint64 duration;    // ms
+    QString serial;     // serial number of the display
+    QString device;
+    QString firmware;
+    QString devInterface;
+    QString port;
+    QString verdict;    // operator verdict: "passed", "failed"
+    quint64 sent;
+    quint64 ack;
+    quint64 nack;
+    QVector<sFrameMetric> frames;
+};
+
+/**
+ * Append-only store of the test runs.
+ *
+ * Runs are appended to a record file and indexed in an index file of fixed
+ * size entries (little endian):
+ *  - header of both files: magic, version
+ *  - record: length (32 bits), run serialized by QDataStream
+ *  - index entry: record offset (64 bits), record length (32 bits), start time
+ *    (ms since epoch, 64 bits), hash of the serial number and of the firmware
+ *    (32 bits each), verdict (8 bits), padding
+ *
+ * Runs are appended in order of their start time, so that a date range is
+ * found by binary search. Queries scan the mapped index only and read the
+ * matching records, the runs are never loaded all at once.
+ */
+class ResultsStore
+{
+public:
+    struct sQuery {
+        QString serial;         // empty: any
+        QString firmware;       // empty: any
+        QDateTime from;         // invalid: open
+        QDateTime to;           // invalid: open
+    };
+
+    ResultsStore();
+
+    bool open(const QString &dir);
+    void close();
+    bool isOpen() const { return mRecords.isOpen(); }
+
+    bool append(const sRunResult &run);
+    quint64 count() const;
+    QVector<quint64> find(const sQuery &query) const;
+    bool read(quint64 idx, sRunResult &run) const;
+
+    static bool parseQuery(const QString &spec, sQuery &query);
+    static QString defaultDir();
+
+private:
+    QFile mRecords;
+    QFile mIndex;
+    qint64 mLastTime;   // start time of the last run
+
+    static const int HEADER_SIZE = 4 + 4;
+    static const int INDEX_ENTRY_SIZE = 8 + 4 + 8 + 4 + 4 + 4;
+
+    static quint32 hash(const QString &text);
+    static bool openFile(QFile &file, quint32 magic);
+};
+
+#endif // RESULTSSTORE_H
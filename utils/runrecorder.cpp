@@ -0,0 +1,144 @@
+#include "runrecorder.h"
+#include <bussniffer.h>
+#include <fd.h>
+
+using namespace fd;
+
+RunRecorder::RunRecorder(SerialProtocol *serialProtocol, QObject *parent) :
+    QObject(parent)
+{
+    mSerialProtocol = serialProtocol;
+    mIsRunning = false;
+    mIsSending = false;
+    mIsPending = false;
+    mEarlyResponse = 0;
+    mSentTime = 0;
+    mOffset = 0;
+
+    connect(mSerialProtocol, SIGNAL(startedSend()), this, SLOT(onStartedSend()));
+    connect(mSerialProtocol, SIGNAL(sent(QByteArray)), this, SLOT(onSent(QByteArray)));
+    connect(mSerialProtocol, SIGNAL(sentFrame(QByteArray)), this, SLOT(onSentFrame(QByteArray)));
+    connect(mSerialProtocol, SIGNAL(receivedACK()), this, SLOT(onReceivedACK()));
+    connect(mSerialProtocol, SIGNAL(receivedNACK()), this, SLOT(onReceivedNACK()));
+}
+
+void RunRecorder::start()
+{
+    mResult = sRunResult();
+    mResult.start = QDateTime::currentDateTime();
+    mResult.duration = 0;
+    mResult.sent = mResult.ack = mResult.nack = 0;
+    mIsSending = false;
+    mIsPending = false;
+    mEarlyResponse = 0;
+    mIsRunning = true;
+    mOffset = 0;
+    mTimer.start();
+}
+
+// continue counting of an interrupted run
+void RunRecorder::resume(const sRunResult &result)
+{
+    mResult = result;
+    mIsSending = false;
+    mIsPending = false;
+    mEarlyResponse = 0;
+    mIsRunning = true;
+    mOffset = result.duration;
+    mTimer.start();
+}
+
+void RunRecorder::stop()
+{
+    if (!mIsRunning)
+        return;
+
+    mResult.duration = mOffset + mTimer.elapsed();
+    mIsRunning = false;
+    mIsSending = false;
+    mIsPending = false;
+}
+
+// transmission begins, a frame still waiting for a response has none
+void RunRecorder::onStartedSend()
+{
+    if (!mIsRunning)
+        return;
+
+    mIsSending = true;
+    mIsPending = false;
+    mEarlyResponse = 0;
+}
+
+// protocol framed by the serial protocol: STX, hex coded protocol, ETX
+void RunRecorder::onSent(QByteArray protocol)
+{
+    record((protocol.length() > PROT_HDR_CMD) ? protocol.at(PROT_HDR_CMD) : 0, 2 * protocol.length() + 2);
+}
+
+// frame sent as it is, e.g. from a corpus
+void RunRecorder::onSentFrame(QByteArray frame)
+{
+    record(BusSniffer::decode(frame).cmd, frame.length());
+}
+
+// end of transmission of a frame
+void RunRecorder::record(uchar cmd, int length)
+{
+    if (!mIsRunning)
+        return;
+
+    ++mResult.sent;
+    mIsSending = false;
+    mIsPending = false;
+
+    if (mResult.frames.count() < MAX_FRAMES)
+    {
+        sFrameMetric metric;
+
+        mSentTime = mOffset + mTimer.elapsed();
+        metric.time = mSentTime;
+        metric.cmd = cmd;
+        metric.response = mEarlyResponse;
+        metric.length = length;
+        metric.latency = mEarlyResponse ? 0 : -1;
+
+        mResult.frames.append(metric);
+        mIsPending = !mEarlyResponse;
+    }
+
+    mEarlyResponse = 0;
+}
+
+void RunRecorder::onReceivedACK()
+{
+    if (mIsRunning)
+    {
+        ++mResult.ack;
+        received(SerialProtocol::ACK);
+    }
+}
+
+void RunRecorder::onReceivedNACK()
+{
+    if (mIsRunning)
+    {
+        ++mResult.nack;
+        received(SerialProtocol::NACK);
+    }
+}
+
+void RunRecorder::received(uchar response)
+{
+    if (mIsSending && !mEarlyResponse)     // response before the end of transmission
+        mEarlyResponse = response;
+
+    if (!mIsPending)
+        return;
+
+    sFrameMetric &metric = mResult.frames.last();
+
+    metric.response = response;
+    metric.latency = mOffset + mTimer.elapsed() - mSentTime;
+    mIsPending = false;
+}
@@ -0,0 +1,59 @@
+#ifndef RUNRECORDER_H
+#define RUNRECORDER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <serialprotocol.h>
+#include <resultsstore.h>
+
+/**
+ * Records the frames of a test run and the response of the display.
+ *
+ * A frame is answered by the next ACK or NACK, a frame sent before an answer
+ * was received has no response. Frames sent from a corpus and protocols
+ * framed by the serial protocol are recorded alike; a response received
+ * before the end of the transmission has latency 0. The result of the run
+ * is completed by the operator verdict and appended to the results store.
+ * A run interrupted (e.g. restored from a checkpoint) is resumed with its
+ * previous result.
+ */
+class RunRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RunRecorder(SerialProtocol *serialProtocol, QObject *parent = 0);
+
+    void start();
+    void resume(const sRunResult &result);
+    void stop();
+    bool isRunning() const { return mIsRunning; }
+    qint64 elapsed() const { return mIsRunning ? mOffset + mTimer.elapsed() : mResult.duration; }
+
+    sRunResult result() const { return mResult; }
+
+    static const int MAX_FRAMES = 100000;   // frame metrics per run
+
+private slots:
+    void onStartedSend();
+    void onSent(QByteArray protocol);
+    void onSentFrame(QByteArray frame);
+    void onReceivedACK();
+    void onReceivedNACK();
+
+private:
+    SerialProtocol *mSerialProtocol;
+    QElapsedTimer mTimer;
+    sRunResult mResult;
+    bool mIsRunning;
+    bool mIsSending;        // frame is being transmitted
+    bool mIsPending;        // last frame waits for a response
+    uchar mEarlyResponse;   // response received during the transmission, 0: none
+    qint64 mSentTime;       // ms
+    qint64 mOffset;         // ms of the run before it was resumed
+
+    void record(uchar cmd, int length);
+    void received(uchar response);
+};
+
+#endif // RUNRECORDER_H
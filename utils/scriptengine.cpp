@@ -0,0 +1,275 @@
+#include "scriptengine.h"
+#include <QDebug>
+#include <QSerialPort>
+#include <fd.h>
+#include <testmanager.h>
+#include <serialprotocol.h>
+
+using namespace fd;
+
+ScriptEngine::ScriptEngine(TestManager *testManager, SerialProtocol *serialProtocol, QObject *parent) :
+    QObject(parent)
+{
+    mTestManager = testManager;
+    mSerialProtocol = serialProtocol;
+    mPc = 0;
+    mIsRunning = false;
+    mIsWaitingAck = false;
+    mCntFailed = 0;
+
+    mTimer.setSingleShot(true);
+
+    connect(&mTimer, SIGNAL(timeout()), this, SLOT(onTimeout()));
+    connect(mSerialProtocol, SIGNAL(receivedACK()), this, SLOT(onReceivedACK()));
+    connect(mSerialProtocol, SIGNAL(receivedNACK()), this, SLOT(onReceivedNACK()));
+    connect(mSerialProtocol, SIGNAL(sent(QByteArray)), this, SLOT(onSent()));
+    connect(mSerialProtocol, SIGNAL(sentFrame(QByteArray)), this, SLOT(onSent()));
+}
+
+// return true on errors
+bool ScriptEngine::load(const QJsonObject &script)
+{
+    stop();
+
+    mName = script[ScriptName].toString();
+    mProgram.clear();
+
+    if (!script[ScriptSteps].isArray() || compile(script[ScriptSteps].toArray()))
+    {
+        qWarning() << "invalid test script" << mName;
+        mProgram.clear();
+        return true;
+    }
+
+    mLoopCount.fill(0, mProgram.count());
+    return false;
+}
+
+// append steps to the program, return true on errors
+bool ScriptEngine::compile(const QJsonArray &steps)
+{
+    static QHash<QString, Op> ops;
+
+    if (ops.isEmpty())
+    {
+        ops[ScriptStepSend] = OpSend;
+        ops[ScriptStepWaitAck] = OpWaitAck;
+        ops[ScriptStepWait] = OpWait;
+        ops[ScriptStepCommand] = OpCommand;
+        ops[ScriptStepBaud] = OpBaud;
+        ops[ScriptStepAssert] = OpAssert;
+        ops[ScriptStepResetCounters] = OpResetCounters;
+        ops[ScriptStepLoop] = OpLoopBegin;
+    }
+
+    foreach (const QJsonValue &value, steps)
+    {
+        QJsonObject step = value.toObject();
+        sInstruction instruction;
+
+        if (!ops.contains(step[ScriptStep].toString()))
+        {
+            qWarning() << "unknown step" << step[ScriptStep].toString();
+            return true;
+        }
+
+        instruction.op = ops.value(step[ScriptStep].toString());
+        instruction.step = step;
+        instruction.jump = -1;
+
+        if (instruction.op != OpLoopBegin)
+        {
+            mProgram.append(instruction);
+            continue;
+        }
+
+        // loop: begin, steps, end jumping back to begin
+        int begin = mProgram.count();
+
+        instruction.step.remove(ScriptSteps);
+        mProgram.append(instruction);
+
+        if (compile(step[ScriptSteps].toArray()))
+            return true;
+
+        instruction.op = OpLoopEnd;
+        instruction.jump = begin;
+        mProgram.append(instruction);
+
+        mProgram[begin].jump = mProgram.count() - 1;
+    }
+
+    return false;
+}
+
+void ScriptEngine::start()
+{
+    stop();
+
+    mPc = 0;
+    mCntFailed = 0;
+    mCounters.clear();
+    mIsRunning = true;
+
+    qDebug() << "test script" << mName << "started";
+    resume();
+}
+
+void ScriptEngine::stop()
+{
+    mTimer.stop();
+    mIsWaitingAck = false;
+    mIsRunning = false;
+}
+
+// execute instructions until a step waits or the program ends
+void ScriptEngine::resume()
+{
+    while (mIsRunning && !mTimer.isActive() && !mIsWaitingAck)
+    {
+        if (mPc >= mProgram.count())
+        {
+            mIsRunning = false;
+            qDebug() << "test script" << mName << (hasPassed() ? "passed" : "failed") << mCounters;
+            emit finished(hasPassed());
+            return;
+        }
+
+        if (execute(mProgram.at(mPc)))
+            ++mPc;
+    }
+}
+
+// return true, if the program continues with the next instruction
+bool ScriptEngine::execute(const sInstruction &instruction)
+{
+    const QJsonObject &step = instruction.step;
+
+    switch (instruction.op)
+    {
+    case OpSend:
+        if (step[ScriptPattern].toString() == ScriptNext)
+        {
+            if (mTestManager->showNextPattern())
+                fail("no test patterns");
+        }
+        else if (mTestManager->showPattern(step[ScriptPattern].toDouble()))
+        {
+            fail("unknown pattern " + QString::number(step[ScriptPattern].toDouble()));
+        }
+        break;
+
+    case OpWaitAck:
+        mIsWaitingAck = true;
+        mTimer.start(step[ScriptTimeout].toInt(1000));
+        return false;   // continued on ACK or timeout
+
+    case OpWait:
+        mTimer.start(step[ScriptTime].toInt());
+        return false;   // continued on timeout
+
+    case OpCommand:
+    {
+        bool ok = true;
+        int cmd = mTestManager->nextCommand();
+
+        if (step[ScriptValue].toString() != ScriptNext)
+            cmd = step[ScriptValue].toString().toInt(&ok, 16);
+
+        if (!ok || mTestManager->setCommand(cmd))
+            fail("unsupported command " + step[ScriptValue].toString());
+        break;
+    }
+
+    case OpBaud:
+    {
+        int baud = step[ScriptValue].toInt();
+        QSerialPort *port = qobject_cast<QSerialPort *>(mSerialProtocol->getDevice());
+
+        if (port && !port->setBaudRate(baud))
+            fail("cannot set baud rate " + QString::number(baud));
+
+        mSerialProtocol->setSerialDataRate(baud);
+        break;
+    }
+
+    case OpAssert:
+    {
+        QString name = step[ScriptCounter].toString();
+        quint64 value = mCounters.value(name);
+
+        if ((step.contains(ScriptMin) && (value < quint64(step[ScriptMin].toDouble()))) ||
+                (step.contains(ScriptMax) && (value > quint64(step[ScriptMax].toDouble()))))
+        {
+            fail(QString("counter %1 = %2 out of [%3, %4]").arg(name).arg(value)
+                 .arg(step[ScriptMin].toDouble()).arg(step[ScriptMax].toDouble()));
+        }
+        break;
+    }
+
+    case OpResetCounters:
+        mCounters.clear();
+        break;
+
+    case OpLoopBegin:
+        mLoopCount[mPc] = step[ScriptCount].toInt(-1);
+
+        if (mLoopCount.at(mPc) == 0)
+        {
+            mPc = instruction.jump + 1;     // skip loop
+            return false;
+        }
+        break;
+
+    case OpLoopEnd:
+        if ((mLoopCount.at(instruction.jump) < 0) || (--mLoopCount[instruction.jump] > 0))
+        {
+            mPc = instruction.jump + 1;     // next iteration
+            return false;
+        }
+        break;
+    }
+
+    return true;
+}
+
+void ScriptEngine::fail(const QString &message)
+{
+    ++mCntFailed;
+    qWarning().noquote() << QString("test script %1, step %2: %3").arg(mName).arg(mPc).arg(message);
+}
+
+void ScriptEngine::onReceivedACK()
+{
+    ++mCounters["ack"];
+
+    if (mIsWaitingAck)
+    {
+        mIsWaitingAck = false;
+        mTimer.stop();
+        ++mPc;
+        resume();
+    }
+}
+
+void ScriptEngine::onReceivedNACK()
+{
+    ++mCounters["nack"];
+}
+
+void ScriptEngine::onSent()
+{
+    ++mCounters["sent"];
+}
+
+void ScriptEngine::onTimeout()
+{
+    if (mIsWaitingAck)
+    {
+        ++mCounters["timeout"];
+        mIsWaitingAck = false;
+    }
+
+    ++mPc;
+    resume();
+}
@@ -0,0 +1,93 @@
+#ifndef SCRIPTENGINE_H
+#define SCRIPTENGINE_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QVector>
+#include <QHash>
+#include <clock.h>
+
+class TestManager;
+class SerialProtocol;
+
+/**
+ * Executes a test script, i.e., a sequence of JSON steps:
+ *
+ *   {"step": "send", "pattern": 3}             display pattern (id or "next")
+ *   {"step": "waitAck", "timeout": 500}        wait for ACK, counts a timeout otherwise
+ *   {"step": "wait", "ms": 10000}
+ *   {"step": "command", "value": "0x26"}       switch command ("next": as in test cycle)
+ *   {"step": "baud", "value": 19200}           switch baud rate of the host interface
+ *   {"step": "assert", "counter": "ack", "min": 1, "max": 3}
+ *   {"step": "resetCounters"}
+ *   {"step": "loop", "count": 100, "steps": [...]}
+ *
+ * Steps are compiled into a flat program and executed by a state machine on
+ * the event loop: a step runs immediately unless it waits, waiting steps
+ * resume the program on their event (ACK or timeout of a single timer).
+ */
+class ScriptEngine : public QObject
+{
+    Q_OBJECT
+public:
+    ScriptEngine(TestManager *testManager, SerialProtocol *serialProtocol, QObject *parent = 0);
+
+    bool load(const QJsonObject &script);
+    void setClock(Clock *clock) { mTimer.setClock(clock); }
+
+    bool isRunning() const { return mIsRunning; }
+    bool hasPassed() const { return mCntFailed == 0; }
+    quint64 counter(const QString &name) const { return mCounters.value(name); }
+
+signals:
+    void finished(bool passed);
+
+public slots:
+    void start();
+    void stop();
+
+private slots:
+    void onReceivedACK();
+    void onReceivedNACK();
+    void onSent();
+    void onTimeout();
+
+private:
+    enum Op {
+        OpSend,
+        OpWaitAck,
+        OpWait,
+        OpCommand,
+        OpBaud,
+        OpAssert,
+        OpResetCounters,
+        OpLoopBegin,
+        OpLoopEnd
+    };
+
+    struct sInstruction {
+        Op op;
+        QJsonObject step;
+        int jump;           // loop: index of the matching loop instruction
+    };
+
+    TestManager *mTestManager;
+    SerialProtocol *mSerialProtocol;
+    QString mName;
+    QVector<sInstruction> mProgram;
+    QVector<int> mLoopCount;        // remaining iterations per loop instruction
+    QHash<QString, quint64> mCounters;
+    ClockTimer mTimer;
+    int mPc;                        // index of the actual instruction
+    bool mIsRunning;
+    bool mIsWaitingAck;
+    int mCntFailed;
+
+    bool compile(const QJsonArray &steps);
+    void resume();
+    bool execute(const sInstruction &instruction);
+    void fail(const QString &message);
+};
+
+#endif // SCRIPTENGINE_H
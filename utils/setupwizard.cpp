@@ -6,7 +6,6 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QHBoxLayout>
-#include <QSerialPortInfo>
 
 using namespace fd;
 
@@ -34,7 +33,7 @@ SetupWizard::SetupWizard(QJsonObject &config, QWidget *parent) :
         }
 
         addPage(new FlurdisplayPage(config));
-        addPage(new HostInterfacePage);
+        addPage(new HostInterfacePage(config[DevInterfaceSection].toArray()));
         addPage(new ConclusionPage);
 
         setWindowTitle(tr("Configuration"));
@@ -136,7 +135,7 @@ FlurdisplayPage::FlurdisplayPage(QJsonObject &config, QWidget *parent) :
     setLayout(layout);
 }
 
-HostInterfacePage::HostInterfacePage(QWidget *parent) :
+HostInterfacePage::HostInterfacePage(const QJsonArray &interfaces, QWidget *parent) :
     QWizardPage(parent)
 {
     setTitle(tr("Host interface"));
@@ -146,20 +145,84 @@ HostInterfacePage::HostInterfacePage(QWidget *parent) :
     hostInterfaceCombo = new QComboBox;
     hostInterfaceLabel->setBuddy(hostInterfaceCombo);
 
-    int idx = 0;
-    foreach (const QSerialPortInfo &info, QSerialPortInfo::availablePorts())
-    {
-        hostInterfaceCombo->insertItem(idx, info.portName(), info.serialNumber());
-    }
+    // ports are enumerated in background, the cached list is shown until the refresh is done
+    connect(PortEnumerator::instance(), SIGNAL(portsChanged()), this, SLOT(onPortsChanged()));
+    onPortsChanged();
 
     registerField("hostInterfaceName", hostInterfaceCombo, "currentText", SIGNAL(currentIndexChanged(QString)));
 
-    QHBoxLayout *layout = new QHBoxLayout;
-    layout->addWidget(hostInterfaceLabel);
-    layout->addWidget(hostInterfaceCombo);
+    // detection of the port and interface of the display
+    detectButton = new QPushButton(tr("&Detect"));
+    detectLabel = new QLabel;
+
+    mProber.setInterfaces(interfaces);
+    connect(detectButton, SIGNAL(clicked()), this, SLOT(onDetect()));
+    connect(&mProber, SIGNAL(detected(PortProber::sResult)), this, SLOT(onDetected(PortProber::sResult)));
+    connect(&mProber, SIGNAL(finished()), this, SLOT(onDetectFinished()));
+
+    QHBoxLayout *portLayout = new QHBoxLayout;
+    portLayout->addWidget(hostInterfaceLabel);
+    portLayout->addWidget(hostInterfaceCombo);
+    portLayout->addWidget(detectButton);
+
+    QVBoxLayout *layout = new QVBoxLayout;
+    layout->addLayout(portLayout);
+    layout->addWidget(detectLabel);
     setLayout(layout);
 }
 
+void HostInterfacePage::initializePage()
+{
+    PortEnumerator::instance()->refresh();  // ports may be plugged since the last enumeration
+}
+
+void HostInterfacePage::onPortsChanged()
+{
+    QString current = hostInterfaceCombo->currentText();
+
+    hostInterfaceCombo->clear();
+
+    foreach (const QSerialPortInfo &info, PortEnumerator::instance()->ports())
+        hostInterfaceCombo->addItem(info.portName(), info.serialNumber());
+
+    if (!current.isEmpty() && (hostInterfaceCombo->findText(current) >= 0))
+        hostInterfaceCombo->setCurrentText(current);
+}
+
+void HostInterfacePage::onDetect()
+{
+    QStringList ports;
+
+    for (int i = 0; i < hostInterfaceCombo->count(); ++i)
+        ports << hostInterfaceCombo->itemText(i);
+
+    detectButton->setEnabled(false);
+    detectLabel->setText(tr("Probing %1 ports...").arg(ports.count()));
+
+    mProber.start(ports);
+}
+
+// pre-fill the configuration with the 1st detected display
+void HostInterfacePage::onDetected(const PortProber::sResult &result)
+{
+    if (mProber.results().count() > 1)
+        return;
+
+    hostInterfaceCombo->setCurrentText(result.port);
+    setField("devInterfaceName", result.interfaceName);
+}
+
+void HostInterfacePage::onDetectFinished()
+{
+    QStringList found;
+
+    foreach (const PortProber::sResult &result, mProber.results())
+        found << QString("%1 (%2)").arg(result.port, result.interfaceName);
+
+    detectButton->setEnabled(true);
+    detectLabel->setText(found.isEmpty() ? tr("No display detected") : tr("Display detected on: ") + found.join(", "));
+}
+
 ConclusionPage::ConclusionPage(QWidget *parent) :
     QWizardPage(parent)
 {
@@ -4,7 +4,11 @@
 #include <QWidget>
 #include <QLabel>
 #include <QComboBox>
+#include <QPushButton>
 #include <QJsonObject>
+#include <QJsonArray>
+#include <portprober.h>
+#include <portenumerator.h>
 
 class SetupWizard : public QWizard
 {
@@ -43,11 +47,24 @@ class HostInterfacePage : public QWizardPage
 {
     Q_OBJECT
 public:
-    HostInterfacePage(QWidget *parent = 0);
+    HostInterfacePage(const QJsonArray &interfaces, QWidget *parent = 0);
+
+protected:
+    void initializePage() Q_DECL_OVERRIDE;
+
+private slots:
+    void onPortsChanged();
+    void onDetect();
+    void onDetected(const PortProber::sResult &result);
+    void onDetectFinished();
 
 private:
     QLabel *hostInterfaceLabel;
     QComboBox *hostInterfaceCombo;
+    QPushButton *detectButton;
+    QLabel *detectLabel;
+
+    PortProber mProber;
 };
 
 class ConclusionPage : public QWizardPage
@@ -0,0 +1,240 @@
+#include "soaktest.h"
+#include <QDebug>
+#include <QTextStream>
+#include <fd.h>
+#include <testmanager.h>
+#include <serialprotocol.h>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+using namespace fd;
+
+SoakTest::SoakTest(TestManager *testManager, SerialProtocol *serialProtocol, quint64 seed, QObject *parent) :
+    QObject(parent)
+{
+    mTestManager = testManager;
+    mSerialProtocol = serialProtocol;
+    mClock = Clock::system();
+    mRandom.setSeed(seed);
+    mIsSeriobus = false;
+    mIsRunning = false;
+    mEnd = 0;
+    mWindowStart = 0;
+    mWindow = mTotal = sCounters();
+
+    mResponseTimer.setSingleShot(true);
+    mResponseTimer.setInterval(100);
+    mWindowTimer.setInterval(60000);
+
+    connect(&mResponseTimer, SIGNAL(timeout()), this, SLOT(onResponseTimeout()));
+    connect(&mWindowTimer, SIGNAL(timeout()), this, SLOT(onWindowTimeout()));
+    connect(mSerialProtocol, SIGNAL(receivedACK()), this, SLOT(onReceivedACK()));
+    connect(mSerialProtocol, SIGNAL(receivedNACK()), this, SLOT(onReceivedNACK()));
+}
+
+void SoakTest::setClock(Clock *clock)
+{
+    mClock = clock ? clock : Clock::system();
+    mResponseTimer.setClock(clock);
+    mWindowTimer.setClock(clock);
+}
+
+// return true on errors
+bool SoakTest::setLogFile(const QString &fileName)
+{
+    mLog.setFileName(fileName);
+
+    if (!mLog.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        qWarning() << "cannot create soak log" << fileName;
+        return true;
+    }
+
+    mLog.write("time_ms,sent,ack,nack,timeout,frames_per_s,ack_per_s,rss_kb,cpu_ms\n");
+    return false;
+}
+
+void SoakTest::start(qint64 duration)
+{
+    mCommands = mTestManager->commands();
+    mIsSeriobus = mTestManager->isSeriobus();
+
+    if (mCommands.isEmpty() || mTestManager->testPatterns().isEmpty())
+    {
+        qWarning() << "soak test: no commands or test patterns";
+        emit finished();
+        return;
+    }
+
+    mIsRunning = true;
+    mEnd = mClock->now() + duration;
+    mWindowStart = mClock->now();
+    mWindow = mTotal = sCounters();
+
+    mWindowTimer.start();
+    sendNext();
+}
+
+void SoakTest::stop()
+{
+    if (!mIsRunning)
+        return;
+
+    mIsRunning = false;
+    mResponseTimer.stop();
+    mWindowTimer.stop();
+
+    logWindow();
+
+    qDebug() << "soak test:" << mTotal.sent << "frames," << mTotal.ack << "ack," << mTotal.nack << "nack,"
+             << mTotal.timeout << "timeouts";
+
+    emit finished();
+}
+
+void SoakTest::sendNext()
+{
+    static const uchar blinks[] = { BLINK_NONE, BLINK_ALL, BLINK_EVENT, BLINK_LOCATION, BLINK_DELIMITER };
+    static const uchar tones[] = { TONE_NONE, TONE_CALL, TONE_ALARM };
+
+    if (mClock->now() >= mEnd)
+    {
+        stop();
+        return;
+    }
+
+    const TestPatternGenerator &testPatterns = mTestManager->testPatterns();
+    QByteArray protocol;
+
+    // random pattern with a protocol, at most one cycle of attempts
+    for (quint64 i = 0; protocol.isEmpty() && (i < testPatterns.count()); ++i)
+    {
+        sTestPattern testPattern = testPatterns.at(mRandom.bounded(testPatterns.count()) + 1);
+        uchar cmd = mCommands.at(mRandom.bounded(mCommands.count()));
+
+        testPattern.blink = blinks[mRandom.bounded(sizeof(blinks) / sizeof(blinks[0]))];
+        testPattern.tone = tones[mRandom.bounded(sizeof(tones) / sizeof(tones[0]))];
+
+        protocol = mTestManager->encodeLrProtocol(testPattern, TestManager::makeLrProtocolHeader(cmd), true);
+    }
+
+    if (protocol.isEmpty())
+    {
+        qWarning() << "soak test: no protocol of the test patterns";
+        stop();
+        return;
+    }
+
+    if (mIsSeriobus)
+        protocol.prepend('W');
+
+    mSerialProtocol->sendFrame(SerialProtocol::frame(protocol));
+
+    ++mWindow.sent;
+    ++mTotal.sent;
+
+    mResponseTimer.start();
+}
+
+void SoakTest::onReceivedACK()
+{
+    if (!mIsRunning || !mResponseTimer.isActive())
+        return;
+
+    ++mWindow.ack;
+    ++mTotal.ack;
+
+    mResponseTimer.stop();
+    sendNext();
+}
+
+void SoakTest::onReceivedNACK()
+{
+    if (!mIsRunning || !mResponseTimer.isActive())
+        return;
+
+    ++mWindow.nack;
+    ++mTotal.nack;
+
+    mResponseTimer.stop();
+    sendNext();
+}
+
+void SoakTest::onResponseTimeout()
+{
+    ++mWindow.timeout;
+    ++mTotal.timeout;
+
+    sendNext();
+}
+
+void SoakTest::onWindowTimeout()
+{
+    logWindow();
+}
+
+void SoakTest::logWindow()
+{
+    qint64 now = mClock->now();
+    qint64 duration = qMax(now - mWindowStart, qint64(1));
+    QString line = QString("%1,%2,%3,%4,%5,%6,%7,%8,%9")
+            .arg(now)
+            .arg(mWindow.sent)
+            .arg(mWindow.ack)
+            .arg(mWindow.nack)
+            .arg(mWindow.timeout)
+            .arg(1000.0 * mWindow.sent / duration, 0, 'f', 1)
+            .arg(1000.0 * mWindow.ack / duration, 0, 'f', 1)    // goodput
+            .arg(residentSize())
+            .arg(cpuTime());
+
+    if (mLog.isOpen())
+    {
+        mLog.write(line.toLatin1() + "\n");
+        mLog.flush();
+    }
+    else
+    {
+        qDebug().noquote() << "soak:" << line;
+    }
+
+    mWindow = sCounters();
+    mWindowStart = now;
+}
+
+// resident memory of the process in kB, -1 if unknown
+qint64 SoakTest::residentSize()
+{
+#ifdef Q_OS_LINUX
+    QFile statm("/proc/self/statm");
+
+    if (statm.open(QIODevice::ReadOnly))
+    {
+        QList<QByteArray> fields = statm.readAll().split(' ');
+
+        if (fields.count() > 1)
+            return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE) / 1024;
+    }
+#endif
+    return -1;
+}
+
+// CPU time (user + system) of the process in ms, -1 if unknown
+qint64 SoakTest::cpuTime()
+{
+#ifdef Q_OS_LINUX
+    QFile stat("/proc/self/stat");
+
+    if (stat.open(QIODevice::ReadOnly))
+    {
+        QByteArray data = stat.readAll();
+        QList<QByteArray> fields = data.mid(data.lastIndexOf(')') + 2).split(' ');  // fields after the command name
+
+        if (fields.count() > 12)
+            return (fields.at(11).toLongLong() + fields.at(12).toLongLong()) * 1000 / sysconf(_SC_CLK_TCK);
+    }
+#endif
+    return -1;
+}
@@ -0,0 +1,78 @@
+#ifndef SOAKTEST_H
+#define SOAKTEST_H
+
+#include <QObject>
+#include <QFile>
+#include <clock.h>
+#include <xorshift.h>
+
+class TestManager;
+class SerialProtocol;
+
+/**
+ * Soak test at line rate.
+ *
+ * Randomized but valid frames (random pattern, command, blink and tone) are
+ * sent back to back: the next frame follows the response (ACK/NACK) or the
+ * response timeout of the previous one. The random sequence is reproducible
+ * from the seed. Per window, the rates of ACK, NACK and timeouts, the
+ * throughput and the resident memory and CPU time of the host are logged.
+ */
+class SoakTest : public QObject
+{
+    Q_OBJECT
+public:
+    SoakTest(TestManager *testManager, SerialProtocol *serialProtocol, quint64 seed, QObject *parent = 0);
+
+    void setClock(Clock *clock);
+    void setWindow(int msec) { mWindowTimer.setInterval(msec); }
+    void setResponseTimeout(int msec) { mResponseTimer.setInterval(msec); }
+    bool setLogFile(const QString &fileName);
+
+    bool isRunning() const { return mIsRunning; }
+    quint64 framesSent() const { return mTotal.sent; }
+
+signals:
+    void finished();
+
+public slots:
+    void start(qint64 duration);
+    void stop();
+
+private slots:
+    void onReceivedACK();
+    void onReceivedNACK();
+    void onResponseTimeout();
+    void onWindowTimeout();
+
+private:
+    struct sCounters {
+        quint64 sent;
+        quint64 ack;
+        quint64 nack;
+        quint64 timeout;
+    };
+
+    TestManager *mTestManager;
+    SerialProtocol *mSerialProtocol;
+    Clock *mClock;
+    ClockTimer mResponseTimer;
+    ClockTimer mWindowTimer;
+    QFile mLog;
+    XorShift mRandom;
+    QList<uchar> mCommands;
+    bool mIsSeriobus;
+    bool mIsRunning;
+    qint64 mEnd;                    // end of the soak test
+    qint64 mWindowStart;
+    sCounters mWindow;
+    sCounters mTotal;
+
+    void sendNext();
+    void logWindow();
+
+    static qint64 residentSize();
+    static qint64 cpuTime();
+};
+
+#endif // SOAKTEST_H
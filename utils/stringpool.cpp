@@ -0,0 +1,31 @@
+#include "stringpool.h"
+
+StringPool::StringPool()
+{
+    clear();
+}
+
+void StringPool::clear()
+{
+    mStrings.clear();
+    mUtf8.clear();
+    mIds.clear();
+
+    intern(QString());  // id 0
+}
+
+quint32 StringPool::intern(const QString &str)
+{
+    QHash<QString, quint32>::ConstIterator itr = mIds.constFind(str);
+
+    if (itr != mIds.constEnd())
+        return itr.value();
+
+    quint32 id = mStrings.count();
+
+    mStrings.append(str);
+    mUtf8.append(str.toUtf8());
+    mIds.insert(str, id);
+
+    return id;
+}
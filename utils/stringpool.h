@@ -0,0 +1,33 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+
+/**
+ * Pool of interned strings of the test patterns.
+ *
+ * Each distinct string is stored once together with its UTF-8 encoding,
+ * patterns refer to it by id. Id 0 is the empty string.
+ */
+class StringPool
+{
+public:
+    StringPool();
+
+    void clear();
+    quint32 intern(const QString &str);
+
+    const QString &string(quint32 id) const { return mStrings.at(id); }
+    const QByteArray &utf8(quint32 id) const { return mUtf8.at(id); }
+    int count() const { return mStrings.count(); }
+
+private:
+    QVector<QString> mStrings;
+    QVector<QByteArray> mUtf8;      // pre-encoded strings
+    QHash<QString, quint32> mIds;
+};
+
+#endif // STRINGPOOL_H
@@ -0,0 +1,150 @@
+#include "testlink.h"
+#include <QEventLoop>
+#include <QDebug>
+#include <fd.h>
+
+using namespace fd;
+
+TestLink::TestLink() :
+    mSimulatedDevice(&mVirtualClock)
+{
+    mFaults = 0;
+    mIsVirtual = false;
+    mIsFinished = false;
+    mByteTime = 0;
+}
+
+TestLink::~TestLink()
+{
+    mSerialProtocol.setDevice(0);
+    delete mFaults;
+}
+
+// return true on errors
+bool TestLink::open(const QJsonObject &config, bool isVirtual, const QString &faultSpec, quint64 seed)
+{
+    QJsonObject hostInterface = config[isVirtual ? DevInterfaceSection : HostInterfaceSection].toObject();
+    QStringList serialParams = hostInterface[ConfigParam].toString().split(",");
+    QIODevice *device = &mSerialPort;
+
+    mIsVirtual = isVirtual;
+
+    if (serialParams.count() != 4)
+    {
+        qWarning() << "invalid host interface param" << serialParams;
+        return true;
+    }
+
+    if (isVirtual)
+    {
+        mSimulatedDevice.setLineRate(serialParams.at(0).toInt(),
+                                     SerialProtocol::bitsPerByte(serialParams.at(2).toInt(), serialParams.at(1) != "n",
+                                                                 serialParams.at(3).toInt()));
+        mSimulatedDevice.open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+        device = &mSimulatedDevice;
+    }
+    else if (openSerialPort(hostInterface[ConfigName].toString(), serialParams, QIODevice::ReadWrite))
+    {
+        return true;
+    }
+
+    if (!faultSpec.isEmpty())
+    {
+        FaultInjectionDevice::sFaults faults;
+
+        if (FaultInjectionDevice::parseFaults(faultSpec, faults))
+            return true;
+
+        mFaults = new FaultInjectionDevice(device, seed);
+        mFaults->setClock(clock());
+        mFaults->setFaults(faults);
+        mFaults->open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+        device = mFaults;
+    }
+
+    mSerialProtocol.setClock(clock());
+    mSerialProtocol.setDevice(device);
+    mSerialProtocol.setSerialFormat(serialParams.at(0).toInt(), serialParams.at(2).toInt(), serialParams.at(1) != "n",
+                                    serialParams.at(3).toInt());
+
+    return false;
+}
+
+// open the host interface receive-only, without serial protocol, return true on errors
+bool TestLink::openPassive(const QJsonObject &config)
+{
+    QJsonObject hostInterface = config[HostInterfaceSection].toObject();
+    QStringList serialParams = hostInterface[ConfigParam].toString().split(",");
+
+    mIsVirtual = false;
+
+    if (serialParams.count() != 4)
+    {
+        qWarning() << "invalid host interface param" << serialParams;
+        return true;
+    }
+
+    if (openSerialPort(hostInterface[ConfigName].toString(), serialParams, QIODevice::ReadOnly))
+        return true;
+
+    mByteTime = qint64(1000000000) * SerialProtocol::bitsPerByte(serialParams.at(2).toInt(), serialParams.at(1) != "n",
+                                                                 serialParams.at(3).toInt()) / qMax(1, serialParams.at(0).toInt());
+    return false;
+}
+
+// return true on errors
+bool TestLink::openSerialPort(const QString &name, const QStringList &serialParams, QIODevice::OpenMode mode)
+{
+    mSerialPort.setPortName(name);
+    mSerialPort.setBaudRate(serialParams.at(0).toInt());
+    mSerialPort.setParity(serialParams.at(1) == "o" ? QSerialPort::OddParity :
+                          serialParams.at(1) == "e" ? QSerialPort::EvenParity : QSerialPort::NoParity);
+    mSerialPort.setDataBits((QSerialPort::DataBits)serialParams.at(2).toInt());
+    mSerialPort.setStopBits((QSerialPort::StopBits)serialParams.at(3).toInt());
+
+    if (!mSerialPort.open(mode))
+    {
+        qWarning() << "Failed to open serial port" << mSerialPort.portName();
+        return true;
+    }
+
+    return false;
+}
+
+// finishedSignal of sender ends exec()
+void TestLink::watch(QObject *sender, const char *finishedSignal)
+{
+    mIsFinished = false;
+    connect(sender, finishedSignal, this, SLOT(onFinished()));
+}
+
+// run until the watched sender has finished
+void TestLink::exec()
+{
+    if (mIsVirtual)
+    {
+        while (!mIsFinished && mVirtualClock.step())
+            ;
+    }
+    else
+    {
+        QEventLoop loop;
+
+        while (!mIsFinished)
+            loop.processEvents(QEventLoop::WaitForMoreEvents);
+    }
+
+    printFaults();
+}
+
+void TestLink::printFaults() const
+{
+    if (!mFaults)
+        return;
+
+    const FaultInjectionDevice::sCounters &counters = mFaults->counters();
+
+    qDebug() << "injected faults:" << counters.bytes << "bytes," << counters.dropped << "dropped,"
+             << counters.flipped << "flipped," << counters.duplicated << "duplicated,"
+             << counters.silenced << "silenced";
+}
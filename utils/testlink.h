@@ -0,0 +1,58 @@
+#ifndef TESTLINK_H
+#define TESTLINK_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QSerialPort>
+#include <clock.h>
+#include <serialprotocol.h>
+#include <simulateddevice.h>
+#include <faultinjectiondevice.h>
+
+/**
+ * Link of the command line test modes to the device under test.
+ *
+ * The serial protocol is connected to the host interface, or to a simulated
+ * device running in virtual time, optionally through a fault injection
+ * device impairing the link. A passive link only receives from the host
+ * interface, e.g. for the bus sniffer.
+ */
+class TestLink : public QObject
+{
+    Q_OBJECT
+public:
+    TestLink();
+    ~TestLink();
+
+    bool open(const QJsonObject &config, bool isVirtual, const QString &faultSpec = QString(), quint64 seed = 0);
+    bool openPassive(const QJsonObject &config);
+
+    bool isVirtual() const { return mIsVirtual; }
+    Clock *clock() { return mIsVirtual ? &mVirtualClock : Clock::system(); }
+    VirtualClock *virtualClock() { return &mVirtualClock; }
+    SerialProtocol *serialProtocol() { return &mSerialProtocol; }
+    SimulatedDevice *simulatedDevice() { return &mSimulatedDevice; }
+    QSerialPort *serialPort() { return &mSerialPort; }
+    qint64 byteTime() const { return mByteTime; }  // ns per byte of the passive link
+
+    void watch(QObject *sender, const char *finishedSignal);
+    void exec();
+    void printFaults() const;
+
+private slots:
+    void onFinished() { mIsFinished = true; }
+
+private:
+    VirtualClock mVirtualClock;     // outlives the timers of the other members
+    SimulatedDevice mSimulatedDevice;
+    QSerialPort mSerialPort;
+    FaultInjectionDevice *mFaults;
+    SerialProtocol mSerialProtocol;
+    bool mIsVirtual;
+    bool mIsFinished;
+    qint64 mByteTime;
+
+    bool openSerialPort(const QString &name, const QStringList &serialParams, QIODevice::OpenMode mode);
+};
+
+#endif // TESTLINK_H
@@ -1,10 +1,13 @@
 #include "testmanager.h"
 #include <QDebug>
 #include <fd.h>
+#include <frameencoder.h>
+#include <QtConcurrent>
 
 using namespace fd;
 
-TestManager::TestManager(SerialProtocol *protocol, QJsonObject config, QJsonObject test, QObject *parent) :
+TestManager::TestManager(SerialProtocol *protocol, QJsonObject config, QJsonObject test,
+                         const TestPatternGenerator *rules, QObject *parent) :
     QObject(parent)
 {
     // internal settings
@@ -18,10 +21,17 @@ TestManager::TestManager(SerialProtocol *protocol, QJsonObject config, QJsonObje
 
     connect(mSerialProtocol, SIGNAL(receivedACK()), this, SLOT(onReceivedACK()));
     connect(mSerialProtocol, SIGNAL(sent(QByteArray)), this, SLOT(onSent(QByteArray)));
+    connect(mSerialProtocol, SIGNAL(sentFrame(QByteArray)), this, SLOT(onSent(QByteArray)));
+    connect(&mIntervalTimer, SIGNAL(timeout()), this, SLOT(onIntervalTimeout()));
+    connect(&mKeepAliveTimer, SIGNAL(timeout()), this, SLOT(onKeepAliveTimeout()));
 
     mIsTestActive = false;
+    mCorpus = 0;
+    mKeepAlive = 0;
+    mCntSuppressed = 0;
+    mKeepAliveTimer.setSingleShot(true);
 
-    if (init(config, test))
+    if (init(config, test, rules))
         qWarning() << "cannot init test manager!";
 
     // setup LR protocol
@@ -34,8 +44,8 @@ TestManager::~TestManager()
 
 }
 
-// return true on errors
-bool TestManager::init(QJsonObject config, QJsonObject test)
+// return true on errors, rules: compiled match rules of test (optional)
+bool TestManager::init(QJsonObject config, QJsonObject test, const TestPatternGenerator *rules)
 {
     if (config.contains(DevSection) && config[DevSection].isObject())
         mConfigDevice = config[DevSection].toObject();
@@ -90,7 +100,12 @@ bool TestManager::init(QJsonObject config, QJsonObject test)
 
     mConfig = config;
 
-    createTestPatterns(test);
+    createTestPatterns(test, rules);
+
+    if (test[RulesChangeOnly].isBool())
+        setChangeOnly(test[RulesChangeOnly].toBool() ? PERIOD_KEEP_ALIVE : 0);
+    else
+        setChangeOnly(test[RulesChangeOnly].toInt());
 
     qDebug() << mSettings[DevMaxChar] << mSettings["interfaceName"] << mSettings[DevInterfaceCmd];
     qDebug() << mConfig[HostInterfaceSection].toObject()[ConfigName].toString() <<
@@ -98,6 +113,20 @@ bool TestManager::init(QJsonObject config, QJsonObject test)
     return false;
 }
 
+void TestManager::setClock(Clock *clock)
+{
+    mIntervalTimer.setClock(clock);
+    mKeepAliveTimer.setClock(clock);
+}
+
+// send only frames changing the content of a display, unchanged content is refreshed after keepAlive ms (0: off)
+void TestManager::setChangeOnly(int keepAlive)
+{
+    mKeepAlive = qMax(keepAlive, 0);
+    mAcked.clear();
+    mKeepAliveTimer.stop();
+}
+
 bool TestManager::start()
 {
     if (mTestPatterns.isEmpty())
@@ -107,22 +136,31 @@ bool TestManager::start()
     }
     else
     {
-        mIntervalTimer = startTimer(500);
-        mCurrTestPattern = mTestPatterns.last();
+        mIntervalTimer.start(500);
+        mCurrTestPattern = mTestPatterns.at(mTestPatterns.last());
         mIsTestActive = true;
+        mAcked.clear();
+        mCntSuppressed = 0;
         emit testStarted();
     }
 
     return mIsTestActive;
 }
 
+// start the test cycle after the pattern with given id and command (e.g. of a checkpoint), return true on errors
+bool TestManager::resume(quint64 id, uchar cmd)
+{
+    if (!id || (id > mTestPatterns.count()) || setCommand(cmd) || !start())
+        return true;
+
+    mCurrTestPattern = mTestPatterns.at(id);
+    return false;
+}
+
 bool TestManager::stop()
 {
-    if (mIntervalTimer)
-    {
-        killTimer(mIntervalTimer);
-        mIntervalTimer = 0;
-    }
+    mIntervalTimer.stop();
+    mKeepAliveTimer.stop();
     mIsTestActive = false;
 
     // send dummy pattern
@@ -151,122 +189,37 @@ bool TestManager::stop()
     return true;
 }
 
-void TestManager::timerEvent(QTimerEvent *evt)
+void TestManager::onIntervalTimeout()
 {
-    if(evt->timerId() == mIntervalTimer)
-    {
-        sTestPattern testPattern = getPatternNextTo(mCurrTestPattern);
+    sTestPattern testPattern = getPatternNextTo(mCurrTestPattern);
 
-        display(testPattern);
+    display(testPattern);
 
-        restartIntervalTimer(PERIOD_TEXT);
-    }
+    restartIntervalTimer(PERIOD_TEXT);
 }
 
 void TestManager::restartIntervalTimer(int ival)
 {
-    if (mTestPatterns.length() > 1)    // start interval timer if at least 2 test patterns exist
-    {
-        mIntervalTimer = startTimer(ival);
-    }
-    else if (mIntervalTimer)
-    {
-        killTimer(mIntervalTimer);
-        mIntervalTimer = 0;
-    }
+    if (mTestPatterns.count() > 1)    // restart interval timer if at least 2 test patterns exist
+        mIntervalTimer.start(ival);
+    else
+        mIntervalTimer.stop();
 }
 
-void TestManager::createTestPatterns(QJsonObject &match)
+void TestManager::createTestPatterns(QJsonObject &match, const TestPatternGenerator *rules)
 {
-    mTestPatterns.clear();
+    if (rules && rules->ruleCount())
+        mTestPatterns = *rules;     // already compiled
+    else if (mTestPatterns.createFromRules(match))
+        qDebug() << "Match rules are not defined!";
 
-    //if (config.contains(RulesSection) && config[RulesSection].isObject())
+    if (match.contains(RulesCoverage) && match[RulesCoverage].isString())
     {
-        //QJsonObject match = config[RulesSection].toObject();
-
-        if (match.contains(RulesMatch) && match[RulesMatch].isArray())
-        {
-            QJsonArray matchRules = match[RulesMatch].toArray();
-            sTestPattern testPattern;
-            testPattern.id = 0;
-
-            qDebug() << "id" << "evtName" << "evtType" << "evtTxt" <<
-                        "locTxt" << "prio" << "blink" << "tone";
-            QJsonArray::Iterator itr;
-            for (itr = matchRules.begin(); itr != matchRules.end(); ++itr)
-            {
-                QJsonObject rule;
-
-                if ((*itr).isObject())
-                {
-                    rule = (*itr).toObject();
-
-                    ++testPattern.id;
-                    testPattern.evtName.clear();
-                    testPattern.evtType.clear();
-                    testPattern.evtTxt.clear();
-                    testPattern.locTxt.clear();
-                    testPattern.prio = 0;
-                    testPattern.blink = 0;
-                    testPattern.tone = 0;
-
-                    if (rule.contains(RulesMatchEvent) && rule[RulesMatchEvent].isString())
-                        testPattern.evtName = rule[RulesMatchEvent].toString();
-                    if (rule.contains(RulesMatchEventType) && rule[RulesMatchEventType].isString())
-                        testPattern.evtType = rule[RulesMatchEventType].toString();
-                    if (rule.contains(RulesMatchEventText) && rule[RulesMatchEventText].isString())
-                        testPattern.evtTxt = rule[RulesMatchEventText].toString();
-                    if (rule.contains(RulesMatchLocationText) && rule[RulesMatchLocationText].isString())
-                        testPattern.locTxt = rule[RulesMatchLocationText].toString();
-                    if (testPattern.locTxt.isEmpty())
-                    {
-                        if (!testPattern.evtType.isEmpty())
-                            testPattern.locTxt = testPattern.evtType;
-                        else
-                            testPattern.locTxt = QString::number(testPattern.id);
-                    }
-                    if (rule.contains(RulesMatchPriority) && rule[RulesMatchPriority].isDouble())
-                        testPattern.prio = rule[RulesMatchPriority].toInt();
-                    if (rule.contains(RulesMatchBlink) && rule[RulesMatchBlink].isString())
-                    {
-                        QStringList strBlink = rule[RulesMatchBlink].toString().split(',');
-
-                        foreach (QString str, strBlink)
-                            str.replace(QRegExp("\\s*"), "");   // remove space
-
-                        testPattern.blink = BLINK_NONE;
-
-                        if (strBlink.contains(RulesMatchBlinkNone))    // "none"
-                            testPattern.blink = BLINK_NONE;
-                        else if (strBlink.contains(RulesMatchBlinkAll))   // "all"
-                            testPattern.blink = BLINK_ALL;
-                        {
-                            if (strBlink.contains(RulesMatchBlinkEvent))    // "event"
-                                testPattern.blink = BLINK_EVENT;
-                            if (strBlink.contains(RulesMatchBlinkLocation))    // "location"
-                                testPattern.blink = BLINK_LOCATION;
-                            if (strBlink.contains(RulesMatchBlinkDelimiter))    // "delimiter"
-                                testPattern.blink = BLINK_DELIMITER;
-                        }
-                    }
-                    if (rule.contains(RulesMatchTone) && rule[RulesMatchTone].isString())
-                    {
-                        if (rule[RulesMatchTone].toString() == RulesMatchToneCall)    // "call"
-                            testPattern.tone = TONE_CALL;
-                        else if (rule[RulesMatchTone].toString() == RulesMatchToneAlarm)    // "alarm"
-                            testPattern.tone = TONE_ALARM;
-                        else if (rule[RulesMatchTone].toString() == RulesMatchToneNone) // "none"
-                            testPattern.tone = TONE_NONE;
-                    }
-
-                    mTestPatterns.append(testPattern);
-
-                    qDebug() << testPattern.id << testPattern.evtName << testPattern.evtType << testPattern.evtTxt <<
-                                testPattern.locTxt << testPattern.prio << testPattern.blink << testPattern.tone;
-                }
-            }
-        }
+        mTestPatterns.setCoverage(CoverageGenerator(CoverageGenerator::modeFromString(match[RulesCoverage].toString()),
+                                                    commands(), mSettings[DevMaxChar].toInt(), mTestPatterns.strings()));
     }
+
+    qDebug() << mTestPatterns.count() << "test patterns generated from" << mTestPatterns.ruleCount() << "rules";
 }
 
 sTestPattern TestManager::getPatternNextTo(sTestPattern &actual)
@@ -275,37 +228,12 @@ sTestPattern TestManager::getPatternNextTo(sTestPattern &actual)
 
     if (!mTestPatterns.isEmpty())
     {
-        int i = actual.id;
+        quint64 i = mTestPatterns.next(actual.id);
 
-        if (i == mTestPatterns.length())
+        if (!i)
         {
-            i = 0;    // 1st element
-            bool ok;
-            int cmd;
-
-            // prepare LR protocol header (currently depends on the device interface)
-            QStringList commands = mSettings[DevInterfaceCmd].toStringList();
-            QString currentCmd = "0x";
-            currentCmd.append(QString::number(mProtocolHeader.at(PROT_HDR_CMD), 16));
-
-            QString nextCmd;
-            if (commands.contains(currentCmd))
-            {
-                int i = commands.indexOf(currentCmd);
-                ++i;
-                if (i < commands.count())
-                    nextCmd = commands.at(i);
-                else
-                    nextCmd = commands.first();
-            }
-            else
-            {
-                nextCmd = commands.first();
-            }
-
-            cmd = nextCmd.toInt(&ok, 16);
-            if (ok)
-                buildLrProtocolHeader(cmd);
+            i = mTestPatterns.first();    // 1st element
+            buildLrProtocolHeader(nextCommand());
         }
 
         testPattern = mTestPatterns.at(i);
@@ -314,30 +242,109 @@ sTestPattern TestManager::getPatternNextTo(sTestPattern &actual)
     return testPattern;
 }
 
+// command of the test cycle
+uchar TestManager::command() const
+{
+    return mProtocolHeader.at(PROT_HDR_CMD);
+}
+
+// command following the actual one in the list of commands of the device interface
+uchar TestManager::nextCommand() const
+{
+    // prepare LR protocol header (currently depends on the device interface)
+    QStringList commands = mSettings[DevInterfaceCmd].toStringList();
+    QString currentCmd = "0x";
+    currentCmd.append(QString::number(mProtocolHeader.at(PROT_HDR_CMD), 16));
+    bool ok;
+
+    QString nextCmd;
+    if (commands.contains(currentCmd))
+    {
+        int i = commands.indexOf(currentCmd);
+        ++i;
+        if (i < commands.count())
+            nextCmd = commands.at(i);
+        else
+            nextCmd = commands.first();
+    }
+    else
+    {
+        nextCmd = commands.first();
+    }
+
+    int cmd = nextCmd.toInt(&ok, 16);
+
+    return ok ? cmd : command();
+}
+
+// return true on errors, i.e., command is not supported by the device interface
+bool TestManager::setCommand(uchar cmd)
+{
+    if (!commands().contains(cmd))
+        return true;
+
+    buildLrProtocolHeader(cmd);
+    return false;
+}
+
+// display the pattern with given id (outside of the test cycle), return true on errors
+bool TestManager::showPattern(quint64 id)
+{
+    if (!id || (id > mTestPatterns.count()))
+        return true;
+
+    sTestPattern testPattern = mTestPatterns.at(id);
+
+    display(testPattern);
+    return false;
+}
+
+// display the pattern following the current one as in the test cycle, return true on errors
+bool TestManager::showNextPattern()
+{
+    if (mTestPatterns.isEmpty())
+        return true;
+
+    sTestPattern testPattern = getPatternNextTo(mCurrTestPattern);
+
+    display(testPattern);
+    return false;
+}
+
 QByteArray TestManager::buildLrProtocol(sTestPattern &testPattern, QByteArray &header)
+{
+    int intervalText = PERIOD_TEXT;
+    QByteArray protocol = encodeLrProtocol(testPattern, header, mCurrTestPattern.id == testPattern.id, &intervalText);
+
+    mSettings["intervalText"] = intervalText;
+
+    return protocol;
+}
+
+// isCurrent: pattern is already displayed, intervalText: display duration of the pattern (optional)
+QByteArray TestManager::encodeLrProtocol(const sTestPattern &testPattern, const QByteArray &header,
+                                         bool isCurrent, int *intervalText) const
 {
     QByteArray protocol;
     QByteArray protocolData;
     QByteArray array;
+    const StringPool &strings = mTestPatterns.strings();
 
     if (header.at(PROT_HDR_CMD) == LR_CMD_28)
     {
         protocol.append(header);
 
+        // destination address
+        protocol[PROT_28_DST_ST] = testPattern.dstSt;
+        protocol[PROT_28_DST_RM] = testPattern.dstRm;
+
         uchar crc = 0;
 
         // event text
-        array = testPattern.evtTxt.toUtf8();
+        array = strings.utf8(testPattern.evtTxt);
 
         if (!array.isEmpty() && (testPattern.blink & BLINK_EVENT))
-        {
-            char ch;
-            for (int i = 0; i < array.length(); ++i)
-            {
-                ch = array.at(i) | BLINK_CHAR;
-                array[i] = ch;
-            }
-        }
+            FrameEncoder::setBlink(array.data(), array.length());
         protocolData.append(array);
 
         // delimiter
@@ -352,11 +359,11 @@ QByteArray TestManager::buildLrProtocol(sTestPattern &testPattern, QByteArray &h
         }
 
         // location text
-        array = testPattern.locTxt.toUtf8();
+        array = strings.utf8(testPattern.locTxt);
 
         QByteArray spaces;
 
-        if (testPattern.evtName.isEmpty())  // blank
+        if (!testPattern.evtName)  // blank
         {
             int empty = mSettings[DevMaxChar].toInt() - array.length() - protocolData.length();
             if (empty >= 0)
@@ -365,7 +372,7 @@ QByteArray TestManager::buildLrProtocol(sTestPattern &testPattern, QByteArray &h
                 array.prepend(spaces);
             }
         }
-        else if (testPattern.evtName == DevTime)
+        else if (strings.string(testPattern.evtName) == DevTime)
         {
             int posColon = array.indexOf(':');
 
@@ -390,14 +397,7 @@ QByteArray TestManager::buildLrProtocol(sTestPattern &testPattern, QByteArray &h
             }
         }
         else if (!array.isEmpty() && (testPattern.blink & BLINK_LOCATION))
-        {
-            char ch;
-            for (int i = 0; i < array.length(); ++i)
-            {
-                ch = array.at(i) | BLINK_CHAR;
-                array[i] = ch;
-            }
-        }
+            FrameEncoder::setBlink(array.data(), array.length());
         protocolData.append(array);
 
         // text type, protocol length
@@ -408,22 +408,24 @@ QByteArray TestManager::buildLrProtocol(sTestPattern &testPattern, QByteArray &h
 
         protocol[PROT_28_PL_LENGTH] = protocolData.length();
 
-        mSettings["intervalText"] = PERIOD_TEXT;
+        if (intervalText)
+            *intervalText = PERIOD_TEXT;
 
         if (protocolData.length() > mSettings[DevMaxChar].toInt())
         {
             if (mSettings[DevOnLongText].toInt() == SLIDING_TEXT)
             {
                 textType |= SLIDING_TEXT;
-                mSettings["intervalText"] = protocolData.length() * mSettings[DevLongTextSlidingCharRate].toInt() + mSettings[DevLongTextSlidingHoldTime].toInt();
+                if (intervalText)
+                    *intervalText = protocolData.length() * mSettings[DevLongTextSlidingCharRate].toInt() + mSettings[DevLongTextSlidingHoldTime].toInt();
             }
             else
                 protocol[PROT_28_PL_LENGTH] = mSettings[DevMaxChar].toInt();
         }
 
-        if (!(mCurrTestPattern.id == testPattern.id)) // if current & new items are different, then set "multiple text" bit in protocol
+        if (!isCurrent) // if current & new items are different, then set "multiple text" bit in protocol
         {
-            if (hasItemWithEqualPriority(testPattern))
+            if (mTestPatterns.hasOtherWithPriority(testPattern))
                 textType |= MULTIPLE_TEXT;
         }
 
@@ -433,8 +435,7 @@ QByteArray TestManager::buildLrProtocol(sTestPattern &testPattern, QByteArray &h
         protocol[PROT_28_TONE] = testPattern.tone;
 
         // crc
-        for (int i = 0; i < protocolData.length(); ++i)
-            crc ^= protocolData.at(i);
+        crc = FrameEncoder::checksum(protocolData.constData(), protocolData.length());
 
         protocolData.append(crc);
         protocol.append(protocolData);
@@ -442,6 +443,9 @@ QByteArray TestManager::buildLrProtocol(sTestPattern &testPattern, QByteArray &h
     else if ((header.at(PROT_HDR_CMD) == LR_CMD_26) ||
              (header.at(PROT_HDR_CMD) == LR_CMD_27))
     {
+        const QString &evtTxt = strings.string(testPattern.evtTxt);
+        const QString &locTxt = strings.string(testPattern.locTxt);
+
         protocol.append(header);
 
         // valence (Wertigkeit)
@@ -457,20 +461,13 @@ QByteArray TestManager::buildLrProtocol(sTestPattern &testPattern, QByteArray &h
         if (header.at(PROT_HDR_CMD) == LR_CMD_26)
         {
             // event text (max 3 chars)
-            if (testPattern.evtTxt.length() > 3)
-                array = testPattern.evtTxt.left(3).toUtf8();
+            if (evtTxt.length() > 3)
+                array = evtTxt.left(3).toUtf8();
             else
-                array = testPattern.evtTxt.toUtf8();
+                array = strings.utf8(testPattern.evtTxt);
 
             if (!array.isEmpty() && (testPattern.blink & BLINK_EVENT))
-            {
-                char ch;
-                for (int i = 0; i < array.length(); ++i)
-                {
-                    ch = array.at(i) | BLINK_CHAR;
-                    array[i] = ch;
-                }
-            }
+                FrameEncoder::setBlink(array.data(), array.length());
 
             protocolData.append(array);
 
@@ -487,11 +484,11 @@ QByteArray TestManager::buildLrProtocol(sTestPattern &testPattern, QByteArray &h
 
             // location text
             int rest = PROT_26_PL_LEN - protocolData.length();
-            if (testPattern.locTxt.length() > rest)
+            if (locTxt.length() > rest)
             {
-                array = testPattern.locTxt.left(rest).toUtf8();
+                array = locTxt.left(rest).toUtf8();
             }
-            else if (testPattern.locTxt.isEmpty())
+            else if (locTxt.isEmpty())
             {
                 array.clear();
                 array.fill('?', rest);
@@ -500,7 +497,7 @@ QByteArray TestManager::buildLrProtocol(sTestPattern &testPattern, QByteArray &h
             {
                 array.clear();
                 array.fill(QChar::Space, rest);
-                array.prepend(testPattern.locTxt.toUtf8());
+                array.prepend(strings.utf8(testPattern.locTxt));
                 array.resize(rest);
             }
 
@@ -509,8 +506,8 @@ QByteArray TestManager::buildLrProtocol(sTestPattern &testPattern, QByteArray &h
         else
         {
             // event text (1 char)
-            if (testPattern.evtTxt.length())
-                array = testPattern.evtTxt.left(1).toUtf8();
+            if (evtTxt.length())
+                array = evtTxt.left(1).toUtf8();
 
             if (!array.isEmpty())
             {
@@ -521,11 +518,11 @@ QByteArray TestManager::buildLrProtocol(sTestPattern &testPattern, QByteArray &h
 
                 // location text
                 int rest = PROT_27_PL_LEN - protocolData.length();
-                if (testPattern.locTxt.length() > rest)
+                if (locTxt.length() > rest)
                 {
-                    array = testPattern.locTxt.left(rest).toUtf8();
+                    array = locTxt.left(rest).toUtf8();
                 }
-                else if (testPattern.locTxt.isEmpty())
+                else if (locTxt.isEmpty())
                 {
                     array.clear();
                     array.fill('?', rest);
@@ -534,7 +531,7 @@ QByteArray TestManager::buildLrProtocol(sTestPattern &testPattern, QByteArray &h
                 {
                     array.clear();
                     array.fill(QChar::Space, rest);
-                    array.prepend(testPattern.locTxt.toUtf8());
+                    array.prepend(strings.utf8(testPattern.locTxt));
                     array.resize(rest);
                 }
 
@@ -560,20 +557,62 @@ void TestManager::display(sTestPattern &testPattern)
     bool isCmdSupported = false;
     bool ok;
     int cmd;
+    QByteArray header = mProtocolHeader;
+
+    if (testPattern.cmd)    // pattern with its own command, i.e., coverage pattern
+        header = makeLrProtocolHeader(testPattern.cmd);
 
     foreach(QString s, mSettings[DevInterfaceCmd].toStringList())
     {
         cmd = s.toInt(&ok,16);
         if (ok)
         {
-            if (cmd == mProtocolHeader.at(PROT_HDR_CMD))
+            if (cmd == header.at(PROT_HDR_CMD))
                 isCmdSupported = true;
         }
     }
 
+    if (isCmdSupported && mCorpus)
+    {
+        QByteArray frame = mCorpus->frame(header.at(PROT_HDR_CMD), testPattern.id);
+
+        if (!frame.isEmpty() && isUnchanged(SerialProtocol::unframe(frame)))
+        {
+            ++mCntSuppressed;
+            mCurrTestPattern = testPattern;
+            return;
+        }
+
+        if (!frame.isEmpty())
+        {
+            mKeepAliveTimer.stop();
+            mSerialProtocol->sendFrame(frame);
+            mLastFrame = frame;
+            mLastProtocol = SerialProtocol::unframe(frame);
+
+            if (mSettings["interfaceName"].toString().contains("Seriobus"))
+                mCntAck = 0;
+            else
+                mCntAck = CNT_VALID_ACK;
+
+            mCurrTestPattern = testPattern;
+            return;
+        }
+    }
+
     if (isCmdSupported)
     {
-        QByteArray protocol = buildLrProtocol(testPattern, mProtocolHeader);
+        QByteArray protocol = buildLrProtocol(testPattern, header);
+
+        if (!protocol.isEmpty() && isUnchanged(protocol))
+        {
+            ++mCntSuppressed;
+            mCurrTestPattern = testPattern;
+            return;
+        }
+
+        mLastFrame.clear();
+        mKeepAliveTimer.stop();
 
         if (!protocol.isEmpty())
         {
@@ -599,50 +638,210 @@ void TestManager::display(sTestPattern &testPattern)
 
 bool TestManager::hasItemWithEqualPriority(sTestPattern &actual)
 {
-    quint64 idx = actual.id;
-    int priority = actual.prio;
+    return mTestPatterns.hasOtherWithPriority(actual);
+}
 
-    for (int i = 0; i < mTestPatterns.length(); ++i)
+QByteArray TestManager::makeLrProtocolHeader(uchar cmd)
+{
+    QByteArray header;
+
+    if (cmd == LR_CMD_28)
     {
-        if (mTestPatterns.at(i).id != idx)
-            if (mTestPatterns.at(i).prio == priority)
-                return true;    // found another item with the equal priority
+        header[PROT_HDR_SEND_ASW] = 0x81;  // sender ASW = 0x81
+        header[PROT_HDR_CMD] = cmd;  // command = 0x28
+        header[PROT_28_DST_ST] = 0x00;  // destination addr = 0.0
+        header[PROT_28_DST_RM] = 0x00;
+        header[PROT_28_SRC_ST] = 0x09;  // source addr = 9.9
+        header[PROT_28_SRC_RM] = 0x09;
+        header[PROT_28_DEV_TYPE] = 0x01;  // destination device = Flurdisplays
+        header[PROT_28_ST_GRP] = 0x00;  // destination station group = 0
+        header[PROT_28_RM_GRP] = 0x00;  // destination room group = 0
+        header[PROT_28_MSG_ID] = 0x01;  // message ID = 1
+        header[PROT_28_TONE] = 0x00;  // tone = none
+        header[PROT_28_TXT_FORMAT] = 0x00;  // format = default
+        header[PROT_28_TXT_COLOR] = 0x00;  // color = default
+        header[PROT_28_PRIORITY] = 0x00;  // priority = low
+        header[PROT_28_PL_LENGTH] = 0x00;
+    }
+    else if ((cmd == LR_CMD_26) ||
+             (cmd == LR_CMD_27))
+    {
+        header[PROT_HDR_SEND_ASW] = 0x81; // sender ASW = 0x81
+        header[PROT_HDR_CMD] = cmd;
+        header[PROT_26_GRP] = 0; // group number = 0
     }
 
-    return false;
+    return header;
 }
 
-void TestManager::buildLrProtocolHeader(uchar cmd)
+// supported commands of the device interface
+QList<uchar> TestManager::commands()
 {
-    if (cmd == LR_CMD_28)
+    QList<uchar> cmds;
+    bool ok;
+
+    foreach (QString s, mSettings[DevInterfaceCmd].toStringList())
     {
-        mProtocolHeader.clear();
-
-        mProtocolHeader[PROT_HDR_SEND_ASW] = 0x81;  // sender ASW = 0x81
-        mProtocolHeader[PROT_HDR_CMD] = cmd;  // command = 0x28
-        mProtocolHeader[PROT_28_DST_ST] = 0x00;  // destination addr = 0.0
-        mProtocolHeader[PROT_28_DST_RM] = 0x00;
-        mProtocolHeader[PROT_28_SRC_ST] = 0x09;  // source addr = 9.9
-        mProtocolHeader[PROT_28_DST_RM] = 0x09;
-        mProtocolHeader[PROT_28_DEV_TYPE] = 0x01;  // destination device = Flurdisplays
-        mProtocolHeader[PROT_28_ST_GRP] = 0x00;  // destination station group = 0
-        mProtocolHeader[PROT_28_RM_GRP] = 0x00;  // destination room group = 0
-        mProtocolHeader[PROT_28_MSG_ID] = 0x01;  // message ID = 1
-        mProtocolHeader[PROT_28_TONE] = 0x00;  // tone = none
-        mProtocolHeader[PROT_28_TXT_FORMAT] = 0x00;  // format = default
-        mProtocolHeader[PROT_28_TXT_COLOR] = 0x00;  // color = default
-        mProtocolHeader[PROT_28_PRIORITY] = 0x00;  // priority = low
-        mProtocolHeader[PROT_28_PL_LENGTH] = 0x00;
+        int cmd = s.toInt(&ok, 16);
+        if (ok && !makeLrProtocolHeader(cmd).isEmpty() && !cmds.contains(cmd))
+            cmds << cmd;
     }
-    else if ((cmd == LR_CMD_26) ||
-             (cmd == LR_CMD_27))
+
+    return cmds;
+}
+
+// patterns of a chunk encoded by a worker thread
+struct sEncodeChunk {
+    quint64 firstId;
+    quint64 count;
+    QVector<QByteArray> frames;
+};
+
+class EncodeChunk
+{
+public:
+    typedef void result_type;
+
+    EncodeChunk(const TestManager *testManager, uchar cmd, bool isSeriobus) :
+        mTestManager(testManager), mCmd(cmd), mIsSeriobus(isSeriobus) {}
+
+    void operator()(sEncodeChunk &chunk) const
+    {
+        const TestPatternGenerator &testPatterns = mTestManager->testPatterns();
+        QByteArray cmdHeader = TestManager::makeLrProtocolHeader(mCmd);
+
+        chunk.frames.reserve(chunk.count);
+
+        for (quint64 id = chunk.firstId; id < chunk.firstId + chunk.count; ++id)
+        {
+            sTestPattern testPattern = testPatterns.at(id);
+            QByteArray header = testPattern.cmd ? TestManager::makeLrProtocolHeader(testPattern.cmd) : cmdHeader;
+            QByteArray protocol = mTestManager->encodeLrProtocol(testPattern, header, false);
+
+            if (protocol.isEmpty())
+            {
+                chunk.frames.append(protocol);
+                continue;
+            }
+
+            if (mIsSeriobus)
+                protocol.prepend('W');
+
+            chunk.frames.append(FrameEncoder::frame(protocol));
+        }
+    }
+
+private:
+    const TestManager *mTestManager;
+    uchar mCmd;
+    bool mIsSeriobus;
+};
+
+// frames of the patterns firstId .. firstId + count - 1, encoded in parallel as in test cycle
+QVector<QByteArray> TestManager::encodeBatch(uchar cmd, quint64 firstId, quint64 count) const
+{
+    static const quint64 CHUNK_SIZE = 1024;
+    QVector<sEncodeChunk> chunks;
+    QVector<QByteArray> frames;
+
+    for (quint64 id = firstId; id < firstId + count; id += CHUNK_SIZE)
+    {
+        sEncodeChunk chunk;
+        chunk.firstId = id;
+        chunk.count = qMin(CHUNK_SIZE, firstId + count - id);
+        chunks.append(chunk);
+    }
+
+    QtConcurrent::blockingMap(chunks, EncodeChunk(this, cmd, mSettings["interfaceName"].toString().contains("Seriobus")));
+
+    frames.reserve(count);
+    foreach (const sEncodeChunk &chunk, chunks)
+        frames += chunk.frames;
+
+    return frames;
+}
+
+// write frames of all test patterns for all supported commands, return true on errors
+bool TestManager::writeCorpus(const QString &fileName)
+{
+    static const quint64 BATCH_SIZE = 65536;
+    FrameCorpus corpus;
+    QList<uchar> cmds = commands();
+    bool error = false;
+
+    if (cmds.isEmpty() || mTestPatterns.isEmpty())
+    {
+        qWarning() << "frame corpus: no commands or test patterns";
+        return true;
+    }
+
+    if (corpus.create(fileName, cmds, mTestPatterns.count(), fingerprint()))
+        return true;
+
+    foreach (uchar cmd, cmds)
     {
-        mProtocolHeader.clear();
+        for (quint64 id = 1; id <= mTestPatterns.count(); id += BATCH_SIZE)
+        {
+            QVector<QByteArray> frames = encodeBatch(cmd, id, qMin(BATCH_SIZE, mTestPatterns.count() - id + 1));
 
-        mProtocolHeader[PROT_HDR_SEND_ASW] = 0x81; // sender ASW = 0x81
-        mProtocolHeader[PROT_HDR_CMD] = cmd;
-        mProtocolHeader[PROT_26_GRP] = 0; // group number = 0
+            foreach (const QByteArray &frame, frames)
+                error |= corpus.append(frame);
+        }
     }
+
+    error |= corpus.finish();
+
+    qDebug() << "frame corpus" << fileName << ":" << corpus.count() << "frames";
+    return error;
+}
+
+// use precompiled frames instead of encoding the test patterns, return true on errors
+bool TestManager::setCorpus(const FrameCorpus *corpus)
+{
+    mCorpus = 0;
+
+    if (!corpus || !corpus->isOpen())
+        return false;
+
+    if (corpus->patternCount() != mTestPatterns.count())
+    {
+        qWarning() << "frame corpus does not match test patterns:" << corpus->patternCount() << "/" << mTestPatterns.count();
+        return true;
+    }
+
+    if (corpus->fingerprint() != fingerprint())
+    {
+        qWarning() << "frame corpus was written for other test patterns, device or interface";
+        return true;
+    }
+
+    mCorpus = corpus;
+    return false;
+}
+
+// hash of the test cycle (compiled rules, coverage, commands, headers, interface),
+// a frame corpus or a checkpoint is valid for the same cycle only
+quint32 TestManager::fingerprint()
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+
+    mTestPatterns.save(out);    // texts, priorities, tones, blinking and addresses of the rules
+    out << mTestPatterns.count() << mSettings[DevMaxChar].toInt() << mSettings[DevOnLongText].toInt();
+    out << mSettings["interfaceName"].toString();  // 'W' prefix on Seriobus
+
+    foreach (uchar cmd, commands())
+        out << cmd << makeLrProtocolHeader(cmd);
+
+    return qHash(data);
+}
+
+void TestManager::buildLrProtocolHeader(uchar cmd)
+{
+    QByteArray header = makeLrProtocolHeader(cmd);
+
+    if (!header.isEmpty())
+        mProtocolHeader = header;
 }
 
 void TestManager::onReceivedACK()
@@ -656,12 +855,61 @@ void TestManager::onReceivedACK()
     if (mCntAck < CNT_VALID_ACK)
         ++mCntAck;
 
+    if (mKeepAlive)
+    {
+        sAcked acked;
+
+        acked.hash = qHash(mLastProtocol);
+        acked.time = mIntervalTimer.clock()->now();
+        mAcked.insert(displayOf(mLastProtocol), acked);
+    }
+
     if (mSettings["interfaceName"].toString().contains("Seriobus"))
     {
-        mSerialProtocol->sendProtocol(mT8Packet);
+        if (mKeepAlive && (mCntAck >= CNT_VALID_ACK))
+            mKeepAliveTimer.start(mKeepAlive);  // content is valid, refresh at low rate only
+        else
+            resendLast();
     }
 }
 
+void TestManager::onKeepAliveTimeout()
+{
+    if (mIsTestActive && !mLastProtocol.isEmpty())
+        resendLast();
+}
+
+void TestManager::resendLast()
+{
+    if (!mLastFrame.isEmpty())
+        mSerialProtocol->sendFrame(mLastFrame);
+    else
+        mSerialProtocol->sendProtocol(mT8Packet);
+}
+
+// display addressed by the protocol: command, LR-address (0x28) or group (0x26, 0x27)
+quint32 TestManager::displayOf(const QByteArray &protocol)
+{
+    uchar cmd = protocol.at(PROT_HDR_CMD);
+
+    if ((cmd == LR_CMD_28) && (protocol.length() > PROT_28_DST_RM))
+        return (cmd << 16) | ((uchar)protocol.at(PROT_28_DST_ST) << 8) | (uchar)protocol.at(PROT_28_DST_RM);
+
+    return (cmd << 16) | ((protocol.length() > PROT_26_GRP) ? (uchar)protocol.at(PROT_26_GRP) : 0);
+}
+
+// true, if change-only transmission is on and the display has acknowledged this content within the keep-alive period
+bool TestManager::isUnchanged(const QByteArray &protocol) const
+{
+    if (!mKeepAlive || (protocol.length() <= PROT_HDR_CMD))
+        return false;
+
+    QHash<quint32, sAcked>::ConstIterator acked = mAcked.constFind(displayOf(protocol));
+
+    return (acked != mAcked.constEnd()) && (acked.value().hash == qHash(protocol)) &&
+            (mIntervalTimer.clock()->now() - acked.value().time < mKeepAlive);
+}
+
 void TestManager::onSent(QByteArray byte)
 {
     if (byte == mDummyProtocol)
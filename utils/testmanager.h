@@ -5,37 +5,51 @@
 #include <serialprotocol.h>
 #include <QJsonObject>
 #include <QJsonArray>
-#include <QTimerEvent>
 #include <QByteArray>
 #include <QSharedPointer>
 #include <QList>
-
-struct sTestPattern {
-    quint64 id;       // event id
-    QString evtName;  // event name
-    QString evtTxt;   // event text
-    QString evtType;  // event type
-    QString locTxt;   // location text
-    QString addr;     // LR-address
-    int prio;         // priority
-    int tone;         // tone type
-    int blink;        // blink mode
-};
+#include <QHash>
+#include <testpatterngenerator.h>
+#include <framecorpus.h>
+#include <clock.h>
 
 class TestManager : public QObject
 {
     Q_OBJECT
 public:
-    explicit TestManager(SerialProtocol *protocol, QJsonObject config, QJsonObject test, QObject *parent = 0);
+    explicit TestManager(SerialProtocol *protocol, QJsonObject config, QJsonObject test,
+                         const TestPatternGenerator *rules = 0, QObject *parent = 0);
     ~TestManager();
 
     bool isTestActive() { return mIsTestActive; }
+    const TestPatternGenerator &testPatterns() const { return mTestPatterns; }
     bool start();
     bool stop();
-    bool init(QJsonObject config, QJsonObject test);
+    bool resume(quint64 id, uchar cmd);
+    quint64 currentPattern() const { return mCurrTestPattern.id; }
+    bool init(QJsonObject config, QJsonObject test, const TestPatternGenerator *rules = 0);
+    void setClock(Clock *clock);
+    void setChangeOnly(int keepAlive);
+    bool isChangeOnly() const { return mKeepAlive > 0; }
+    quint64 framesSuppressed() const { return mCntSuppressed; }
+
+    QList<uchar> commands();
+    bool isSeriobus() const { return mSettings["interfaceName"].toString().contains("Seriobus"); }
+    uchar command() const;
+    uchar nextCommand() const;
+    bool setCommand(uchar cmd);
+    bool showPattern(quint64 id);
+    bool showNextPattern();
+    bool writeCorpus(const QString &fileName);
+    bool setCorpus(const FrameCorpus *corpus);
+    quint32 fingerprint();
 
     void buildLrProtocolHeader(uchar cmd);
+    static QByteArray makeLrProtocolHeader(uchar cmd);
     QByteArray buildLrProtocol(sTestPattern &testPattern, QByteArray &header);
+    QByteArray encodeLrProtocol(const sTestPattern &testPattern, const QByteArray &header,
+                                bool isCurrent, int *intervalText = 0) const;
+    QVector<QByteArray> encodeBatch(uchar cmd, quint64 firstId, quint64 count) const;
 signals:
     void testStarted();
     void testStopped();
@@ -44,8 +58,10 @@ signals:
 
 public slots:
 private slots:
+    void onIntervalTimeout();
     void onReceivedACK();
     void onSent(QByteArray byte);
+    void onKeepAliveTimeout();
 private:
 
     QMap<QString, QVariant> mSettings;
@@ -56,6 +72,8 @@ private:
     QByteArray mLastProtocol;   // in Seriobus interface, protocol is emitted on received ack
     QByteArray mT8Packet;   // in Seriobus interface, packet is sent serially on received ack
     QByteArray mDummyProtocol;  // sent on test stop
+    const FrameCorpus *mCorpus; // precompiled frames of the test patterns
+    QByteArray mLastFrame;      // last frame sent from corpus
 
     QJsonObject mConfig;
     QJsonObject mConfigDevice;
@@ -64,13 +82,27 @@ private:
 
     QJsonObject mTest;
 
-    int mIntervalTimer;
+    ClockTimer mIntervalTimer;
+
+    // change-only transmission: content hash and time of the last acknowledged frame per display
+    struct sAcked {
+        uint hash;
+        qint64 time;
+    };
+
+    int mKeepAlive;             // ms, 0: every frame is sent
+    QHash<quint32, sAcked> mAcked;
+    ClockTimer mKeepAliveTimer; // refresh of the last frame on Seriobus
+    quint64 mCntSuppressed;
+
+    static quint32 displayOf(const QByteArray &protocol);
+    bool isUnchanged(const QByteArray &protocol) const;
+    void resendLast();
 
-    void timerEvent(QTimerEvent *evt);
     void restartIntervalTimer(int ival);
 
-    QList<sTestPattern> mTestPatterns;
-    void createTestPatterns(QJsonObject &config);
+    TestPatternGenerator mTestPatterns;
+    void createTestPatterns(QJsonObject &config, const TestPatternGenerator *rules);
     sTestPattern mCurrTestPattern;
     sTestPattern getPatternNextTo(sTestPattern &actual);
     void display(sTestPattern &testPattern);
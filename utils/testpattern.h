@@ -0,0 +1,21 @@
+#ifndef TESTPATTERN_H
+#define TESTPATTERN_H
+
+#include <QtGlobal>
+
+// handle of a test pattern, texts are ids of the strings in the pattern's StringPool
+struct sTestPattern {
+    quint64 id = 0;       // event id
+    quint32 evtName = 0;  // event name
+    quint32 evtTxt = 0;   // event text
+    quint32 evtType = 0;  // event type
+    quint32 locTxt = 0;   // location text
+    qint32 prio = 0;      // priority
+    uchar tone = 0;       // tone type
+    uchar blink = 0;      // blink mode
+    uchar dstSt = 0;      // destination station (0 = all), LR-address = dstSt.dstRm
+    uchar dstRm = 0;      // destination room (0 = all)
+    uchar cmd = 0;        // LR command (0 = command of the test cycle)
+};
+
+#endif // TESTPATTERN_H
@@ -0,0 +1,487 @@
+#include "testpatterngenerator.h"
+#include <QDebug>
+#include <QStringList>
+#include <QJsonArray>
+#include <QRegExp>
+#include <algorithm>
+#include <fd.h>
+
+using namespace fd;
+
+TestPatternGenerator::TestPatternGenerator()
+{
+    mCount = 0;
+}
+
+void TestPatternGenerator::clear()
+{
+    mStrings.clear();
+    mEvtName.clear();
+    mEvtTxt.clear();
+    mEvtType.clear();
+    mLocTxt.clear();
+    mPrio.clear();
+    mTone.clear();
+    mBlink.clear();
+    mFirstId.clear();
+    mCntPatterns.clear();
+    mAddrList.clear();
+    mCount = 0;
+    mCoverage = CoverageGenerator();
+    mIndex.clear();
+}
+
+void TestPatternGenerator::setCoverage(const CoverageGenerator &coverage)
+{
+    mCoverage = coverage;
+
+    mIndex.remove(PriorityIndex::CoverageKey);
+
+    if (mCoverage.count())  // generated patterns are ordered as a single run, they count themselves
+        mIndex.insertOrdered(PriorityIndex::CoverageKey, PRTY_COVERAGE, mCount + 1);
+}
+
+void TestPatternGenerator::setPriority(int ruleIdx, int prio)
+{
+    if ((ruleIdx < 0) || (ruleIdx >= ruleCount()))
+        return;
+
+    mPrio[ruleIdx] = prio;
+    mIndex.insert(ruleIdx, prio, mFirstId.at(ruleIdx), mCntPatterns.at(ruleIdx), mAddrList.at(ruleIdx));
+}
+
+// compiled rules, coverage patterns are not stored
+void TestPatternGenerator::save(QDataStream &out) const
+{
+    out << quint32(mStrings.count());
+    for (int i = 0; i < mStrings.count(); ++i)
+        out << mStrings.string(i);
+
+    out << mEvtName << mEvtTxt << mEvtType << mLocTxt << mPrio << mTone << mBlink << mCntPatterns;
+
+    foreach (const QVector<sAddrRange> &addrList, mAddrList)
+    {
+        out << quint32(addrList.count());
+        foreach (const sAddrRange &range, addrList)
+            out << range.first << range.step << range.count;
+    }
+}
+
+// return true on errors
+bool TestPatternGenerator::load(QDataStream &in)
+{
+    quint32 cnt;
+    QString str;
+
+    clear();
+
+    in >> cnt;
+    for (quint32 i = 0; (i < cnt) && (in.status() == QDataStream::Ok); ++i)
+    {
+        in >> str;
+        if (mStrings.intern(str) != i)
+        {
+            clear();
+            return true;    // strings are not unique
+        }
+    }
+
+    in >> mEvtName >> mEvtTxt >> mEvtType >> mLocTxt >> mPrio >> mTone >> mBlink >> mCntPatterns;
+
+    int rules = mEvtName.count();
+
+    if ((mEvtTxt.count() != rules) || (mEvtType.count() != rules) || (mLocTxt.count() != rules) ||
+            (mPrio.count() != rules) || (mTone.count() != rules) || (mBlink.count() != rules) ||
+            (mCntPatterns.count() != rules))
+    {
+        clear();
+        return true;
+    }
+
+    for (int i = 0; (i < rules) && (in.status() == QDataStream::Ok); ++i)
+    {
+        QVector<sAddrRange> addrList;
+        sAddrRange range;
+
+        in >> cnt;
+        for (quint32 j = 0; (j < cnt) && (in.status() == QDataStream::Ok); ++j)
+        {
+            in >> range.first >> range.step >> range.count;
+            addrList.append(range);
+        }
+
+        mAddrList.append(addrList);
+        mFirstId.append(mCount + 1);
+        mIndex.insert(i, mPrio.at(i), mCount + 1, mCntPatterns.at(i), addrList);
+        mCount += mCntPatterns.at(i);
+    }
+
+    if (in.status() != QDataStream::Ok)
+    {
+        clear();
+        return true;
+    }
+
+    return false;
+}
+
+// return true on errors
+bool TestPatternGenerator::createFromRules(const QJsonObject &match)
+{
+    clear();
+
+    if (!match.contains(RulesMatch) || !match[RulesMatch].isArray())
+        return true;
+
+    QJsonArray matchRules = match[RulesMatch].toArray();
+
+    qDebug() << "rule" << "evtName" << "evtType" << "evtTxt" <<
+                "locTxt" << "prio" << "blink" << "tone" << "patterns";
+
+    for (QJsonArray::ConstIterator itr = matchRules.constBegin(); itr != matchRules.constEnd(); ++itr)
+    {
+        if ((*itr).isObject())
+        {
+            if (addRule((*itr).toObject()))
+                qWarning() << "invalid address list in rule" << (*itr).toObject()["_ruleName"].toString();
+        }
+    }
+
+    return false;
+}
+
+// return true on errors
+bool TestPatternGenerator::addRule(const QJsonObject &rule)
+{
+    QString evtName, evtType, evtTxt, locTxt;
+    sTestPattern testPattern;
+    QVector<sAddrRange> addrList;
+
+    if (rule.contains(RulesMatchEvent) && rule[RulesMatchEvent].isString())
+        evtName = rule[RulesMatchEvent].toString();
+    if (rule.contains(RulesMatchEventType) && rule[RulesMatchEventType].isString())
+        evtType = rule[RulesMatchEventType].toString();
+    if (rule.contains(RulesMatchEventText) && rule[RulesMatchEventText].isString())
+        evtTxt = rule[RulesMatchEventText].toString();
+    if (rule.contains(RulesMatchLocationText) && rule[RulesMatchLocationText].isString())
+        locTxt = rule[RulesMatchLocationText].toString();
+    if (locTxt.isEmpty())
+    {
+        if (!evtType.isEmpty())
+            locTxt = evtType;
+        else
+            locTxt = QString::number(ruleCount() + 1);
+    }
+    if (rule.contains(RulesMatchPriority) && rule[RulesMatchPriority].isDouble())
+        testPattern.prio = rule[RulesMatchPriority].toInt();
+    if (rule.contains(RulesMatchBlink) && rule[RulesMatchBlink].isString())
+    {
+        QStringList strBlink = rule[RulesMatchBlink].toString().split(',');
+
+        for (int i = 0; i < strBlink.count(); ++i)
+            strBlink[i].replace(QRegExp("\\s*"), "");   // remove space
+
+        testPattern.blink = BLINK_NONE;
+
+        if (strBlink.contains(RulesMatchBlinkNone))    // "none"
+            testPattern.blink = BLINK_NONE;
+        else if (strBlink.contains(RulesMatchBlinkAll))   // "all"
+            testPattern.blink = BLINK_ALL;
+        {
+            if (strBlink.contains(RulesMatchBlinkEvent))    // "event"
+                testPattern.blink = BLINK_EVENT;
+            if (strBlink.contains(RulesMatchBlinkLocation))    // "location"
+                testPattern.blink = BLINK_LOCATION;
+            if (strBlink.contains(RulesMatchBlinkDelimiter))    // "delimiter"
+                testPattern.blink = BLINK_DELIMITER;
+        }
+    }
+    if (rule.contains(RulesMatchTone) && rule[RulesMatchTone].isString())
+    {
+        if (rule[RulesMatchTone].toString() == RulesMatchToneCall)    // "call"
+            testPattern.tone = TONE_CALL;
+        else if (rule[RulesMatchTone].toString() == RulesMatchToneAlarm)    // "alarm"
+            testPattern.tone = TONE_ALARM;
+        else if (rule[RulesMatchTone].toString() == RulesMatchToneNone) // "none"
+            testPattern.tone = TONE_NONE;
+    }
+
+    bool error = false;
+
+    if (rule.contains(RulesMatchAddrList))
+        error = parseAddrList(rule[RulesMatchAddrList], addrList);
+
+    quint64 cnt = 0;
+    foreach (const sAddrRange &range, addrList)
+        cnt += range.count;
+
+    if (!cnt)    // no (valid) address list: single pattern to all displays
+    {
+        addrList.clear();
+        cnt = 1;
+    }
+
+    mEvtName.append(mStrings.intern(evtName));
+    mEvtTxt.append(mStrings.intern(evtTxt));
+    mEvtType.append(mStrings.intern(evtType));
+    mLocTxt.append(mStrings.intern(locTxt));
+    mPrio.append(testPattern.prio);
+    mTone.append(testPattern.tone);
+    mBlink.append(testPattern.blink);
+    mFirstId.append(mCount + 1);
+    mCntPatterns.append(cnt);
+    mAddrList.append(addrList);
+
+    mIndex.insert(ruleCount() - 1, testPattern.prio, mCount + 1, cnt, addrList);
+    mCount += cnt;
+
+    if (mCoverage.count())  // coverage patterns follow the patterns of the rules
+        setCoverage(mCoverage);
+
+    qDebug() << ruleCount() << evtName << evtType << evtTxt <<
+                locTxt << testPattern.prio << testPattern.blink << testPattern.tone << cnt;
+
+    return error;
+}
+
+// return index of the rule which generates the pattern with given id, -1 if not found
+int TestPatternGenerator::ruleOf(quint64 id) const
+{
+    if (!id || id > mCount)
+        return -1;
+
+    QVector<quint64>::ConstIterator itr = std::upper_bound(mFirstId.constBegin(), mFirstId.constEnd(), id);
+
+    return (itr - mFirstId.constBegin()) - 1;
+}
+
+sTestPattern TestPatternGenerator::at(quint64 id) const
+{
+    sTestPattern testPattern;
+    int idx = ruleOf(id);
+
+    if ((idx < 0) && (id > mCount))
+    {
+        testPattern = mCoverage.at(id - mCount - 1);
+        testPattern.id = id;
+        return testPattern;
+    }
+
+    if (idx < 0)
+        return testPattern;
+
+    testPattern.id = id;
+    testPattern.evtName = mEvtName.at(idx);
+    testPattern.evtTxt = mEvtTxt.at(idx);
+    testPattern.evtType = mEvtType.at(idx);
+    testPattern.locTxt = mLocTxt.at(idx);
+    testPattern.prio = mPrio.at(idx);
+    testPattern.tone = mTone.at(idx);
+    testPattern.blink = mBlink.at(idx);
+
+    if (!mAddrList.at(idx).isEmpty())
+    {
+        quint16 addr = addrAt(mAddrList.at(idx), id - mFirstId.at(idx));
+
+        testPattern.dstSt = addr >> 8;
+        testPattern.dstRm = addr & 0xFF;
+    }
+
+    return testPattern;
+}
+
+quint64 TestPatternGenerator::firstIdOf(int key) const
+{
+    if (key == PriorityIndex::CoverageKey)
+        return mCount + 1;
+
+    return (key < 0) ? 0 : mFirstId.at(key);
+}
+
+quint64 TestPatternGenerator::countOf(int key) const
+{
+    if (key == PriorityIndex::CoverageKey)
+        return mCoverage.count();
+
+    return (key < 0) ? 0 : mCntPatterns.at(key);
+}
+
+// return id of the 1st pattern in the order of priority, 0 if there is no pattern
+quint64 TestPatternGenerator::first() const
+{
+    return firstIdOf(mIndex.first());
+}
+
+// return id of the last pattern in the order of priority, 0 if there is no pattern
+quint64 TestPatternGenerator::last() const
+{
+    int key = mIndex.last();
+
+    if (key < 0)
+        return 0;
+
+    return firstIdOf(key) + countOf(key) - 1;
+}
+
+// return id of the pattern next to given one in the order of priority, 0 after the last pattern
+quint64 TestPatternGenerator::next(quint64 id) const
+{
+    int key;
+
+    if ((id > mCount) && (id <= count()))
+        key = PriorityIndex::CoverageKey;
+    else
+        key = ruleOf(id);
+
+    if (key < 0)
+        return 0;
+
+    if (id + 1 < firstIdOf(key) + countOf(key))
+        return id + 1;  // next address of the rule
+
+    return firstIdOf(mIndex.next(key));
+}
+
+// true, if another pattern with equal priority is shown on the same display
+bool TestPatternGenerator::hasOtherWithPriority(const sTestPattern &actual) const
+{
+    quint16 addr = (actual.dstSt << 8) | actual.dstRm;
+    quint64 cnt = mCoverage.countWithPriority(actual.prio);    // coverage patterns are sent to all displays
+
+    if (addr)
+        cnt += mIndex.countOnDisplay(actual.prio, addr);
+    else
+        cnt += mIndex.count(actual.prio);
+
+    return cnt > 1; // actual pattern itself is counted too
+}
+
+quint16 TestPatternGenerator::addrAt(const QVector<sAddrRange> &addrList, quint64 idx)
+{
+    foreach (const sAddrRange &range, addrList)
+    {
+        if (idx < range.count)
+            return range.first + idx * range.step;
+
+        idx -= range.count;
+    }
+
+    return 0;
+}
+
+bool TestPatternGenerator::containsAddr(const QVector<sAddrRange> &addrList, quint16 addr)
+{
+    foreach (const sAddrRange &range, addrList)
+    {
+        if (addr < range.first)
+            continue;
+
+        int diff = addr - range.first;
+
+        if (!(diff % range.step) && (diff / range.step < range.count))
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * Address list contains the lists of stations and supervisors, i.e.,
+ * "addrList": { "stations": "1-63", "supervisors": "9.1,9.3-9.5" }
+ * A list is a string of comma separated items or an array of such strings.
+ * Items:
+ *  - "st"          station, all rooms
+ *  - "st1-st2"     range of stations
+ *  - "st.rm"       room in station
+ *  - "st.rm1-rm2"  range of rooms in station (also "st.rm1-st.rm2")
+ */
+// return true on errors
+bool TestPatternGenerator::parseAddrList(const QJsonValue &value, QVector<sAddrRange> &addrList)
+{
+    bool error = false;
+
+    addrList.clear();
+
+    if (!value.isObject())
+        return true;
+
+    QStringList lists;
+    lists << RulesMatchAddrListStations << RulesMatchAddrListSupervisors;
+
+    foreach (QString list, lists)
+    {
+        QJsonValue items = value.toObject().value(list);
+        QStringList strItems;
+
+        if (items.isString())
+        {
+            strItems = items.toString().split(',', QString::SkipEmptyParts);
+        }
+        else if (items.isArray())
+        {
+            foreach (const QJsonValue &item, items.toArray())
+                strItems << item.toString().split(',', QString::SkipEmptyParts);
+        }
+        else if (!items.isUndefined())
+        {
+            error = true;
+        }
+
+        foreach (QString item, strItems)
+        {
+            if (parseAddrItem(item.trimmed(), addrList))
+            {
+                qWarning() << "invalid address" << item << "in" << list;
+                error = true;
+            }
+        }
+    }
+
+    return error;
+}
+
+// return true on errors
+bool TestPatternGenerator::parseAddrItem(const QString &item, QVector<sAddrRange> &addrList)
+{
+    QRegExp station("(\\d+)(-(\\d+))?");
+    QRegExp room("(\\d+)\\.(\\d+)(-((\\d+)\\.)?(\\d+))?");
+    sAddrRange range;
+    int first, last;
+
+    if (station.exactMatch(item))
+    {
+        first = station.cap(1).toInt();
+        last = station.cap(3).isEmpty() ? first : station.cap(3).toInt();
+
+        if ((first > 0xFF) || (last > 0xFF) || (last < first))
+            return true;
+
+        range.first = first << 8;
+        range.step = 0x100;
+        range.count = last - first + 1;
+    }
+    else if (room.exactMatch(item))
+    {
+        int st = room.cap(1).toInt();
+
+        if (!room.cap(5).isEmpty() && (room.cap(5).toInt() != st))
+            return true;    // rooms of different stations
+
+        first = room.cap(2).toInt();
+        last = room.cap(6).isEmpty() ? first : room.cap(6).toInt();
+
+        if ((st > 0xFF) || (first > 0xFF) || (last > 0xFF) || (last < first))
+            return true;
+
+        range.first = (st << 8) | first;
+        range.step = 1;
+        range.count = last - first + 1;
+    }
+    else
+    {
+        return true;
+    }
+
+    addrList.append(range);
+    return false;
+}
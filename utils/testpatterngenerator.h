@@ -0,0 +1,106 @@
+#ifndef TESTPATTERNGENERATOR_H
+#define TESTPATTERNGENERATOR_H
+
+#include <QString>
+#include <QVector>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QDataStream>
+#include <testpattern.h>
+#include <coveragegenerator.h>
+#include <stringpool.h>
+#include <priorityindex.h>
+
+/**
+ * Generates test patterns from the match rules.
+ *
+ * A rule with an address list ("addrList") is expanded into one pattern per
+ * LR-address. Patterns are not stored, but computed on request from their id,
+ * so that memory usage depends on the number of rules only.
+ * Generated coverage patterns follow the patterns of the rules.
+ *
+ * Rules are stored as parallel arrays, their texts are interned in a string
+ * pool. A pattern is a small handle referring to the strings by id.
+ *
+ * The test cycle iterates the patterns by priority (highest first), then by id.
+ */
+class TestPatternGenerator
+{
+public:
+    class const_iterator
+    {
+    public:
+        const_iterator(const TestPatternGenerator *generator, quint64 id) :
+            mGenerator(generator), mId(id) {}
+
+        sTestPattern operator*() const { return mGenerator->at(mId); }
+        const_iterator &operator++() { ++mId; return *this; }
+        bool operator==(const const_iterator &other) const { return mId == other.mId; }
+        bool operator!=(const const_iterator &other) const { return mId != other.mId; }
+        quint64 id() const { return mId; }
+
+    private:
+        const TestPatternGenerator *mGenerator;
+        quint64 mId;
+    };
+
+    TestPatternGenerator();
+
+    void clear();
+    bool addRule(const QJsonObject &rule);
+    bool createFromRules(const QJsonObject &match);
+    void setCoverage(const CoverageGenerator &coverage);
+    void setPriority(int ruleIdx, int prio);
+
+    void save(QDataStream &out) const;
+    bool load(QDataStream &in);
+
+    bool isEmpty() const { return count() == 0; }
+    quint64 count() const { return mCount + mCoverage.count(); }
+    int ruleCount() const { return mFirstId.count(); }
+    int ruleOf(quint64 id) const;
+
+    StringPool &strings() { return mStrings; }
+    const StringPool &strings() const { return mStrings; }
+    const QString &string(quint32 id) const { return mStrings.string(id); }
+
+    sTestPattern at(quint64 id) const;     // id = 1 .. count()
+    const_iterator begin() const { return const_iterator(this, 1); }
+    const_iterator end() const { return const_iterator(this, count() + 1); }
+
+    quint64 first() const;
+    quint64 last() const;
+    quint64 next(quint64 id) const;
+
+    bool hasOtherWithPriority(const sTestPattern &actual) const;
+
+    static bool parseAddrList(const QJsonValue &value, QVector<sAddrRange> &addrList);
+    static quint16 addrAt(const QVector<sAddrRange> &addrList, quint64 idx);
+    static bool containsAddr(const QVector<sAddrRange> &addrList, quint16 addr);
+
+private:
+    StringPool mStrings;
+
+    // rules
+    QVector<quint32> mEvtName;
+    QVector<quint32> mEvtTxt;
+    QVector<quint32> mEvtType;
+    QVector<quint32> mLocTxt;
+    QVector<qint32> mPrio;
+    QVector<uchar> mTone;
+    QVector<uchar> mBlink;
+    QVector<quint64> mFirstId;              // id of the 1st pattern of the rule
+    QVector<quint64> mCntPatterns;          // number of patterns (addresses) of the rule
+    QVector<QVector<sAddrRange> > mAddrList;  // empty: single pattern to address 0.0
+
+    quint64 mCount;     // number of patterns of the rules
+    CoverageGenerator mCoverage;
+    PriorityIndex mIndex;
+
+    quint64 firstIdOf(int key) const;
+    quint64 countOf(int key) const;
+
+    static bool parseAddrItem(const QString &item, QVector<sAddrRange> &addrList);
+};
+
+#endif // TESTPATTERNGENERATOR_H
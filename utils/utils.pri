@@ -1,7 +1,55 @@
 HEADERS  += \
     $$PWD/testmanager.h \
+    $$PWD/testpattern.h \
+    $$PWD/testpatterngenerator.h \
+    $$PWD/coveragegenerator.h \
+    $$PWD/priorityindex.h \
+    $$PWD/stringpool.h \
+    $$PWD/configloader.h \
+    $$PWD/goldencorpus.h \
+    $$PWD/goldentimeline.h \
+    $$PWD/displaymodel.h \
+    $$PWD/clock.h \
+    $$PWD/scriptengine.h \
+    $$PWD/soaktest.h \
+    $$PWD/xorshift.h \
+    $$PWD/protocolfuzzer.h \
+    $$PWD/testlink.h \
+    $$PWD/busscheduler.h \
+    $$PWD/bustest.h \
+    $$PWD/firmwareprofiler.h \
+    $$PWD/baudsweep.h \
+    $$PWD/portprober.h \
+    $$PWD/portenumerator.h \
+    $$PWD/portpool.h \
+    $$PWD/resultsstore.h \
+    $$PWD/runrecorder.h \
+    $$PWD/checkpointjournal.h \
     $$PWD/setupwizard.h
 
 SOURCES += \
     $$PWD/testmanager.cpp \
+    $$PWD/testpatterngenerator.cpp \
+    $$PWD/coveragegenerator.cpp \
+    $$PWD/priorityindex.cpp \
+    $$PWD/stringpool.cpp \
+    $$PWD/configloader.cpp \
+    $$PWD/goldencorpus.cpp \
+    $$PWD/goldentimeline.cpp \
+    $$PWD/displaymodel.cpp \
+    $$PWD/clock.cpp \
+    $$PWD/scriptengine.cpp \
+    $$PWD/soaktest.cpp \
+    $$PWD/protocolfuzzer.cpp \
+    $$PWD/testlink.cpp \
+    $$PWD/busscheduler.cpp \
+    $$PWD/bustest.cpp \
+    $$PWD/firmwareprofiler.cpp \
+    $$PWD/baudsweep.cpp \
+    $$PWD/portprober.cpp \
+    $$PWD/portenumerator.cpp \
+    $$PWD/portpool.cpp \
+    $$PWD/resultsstore.cpp \
+    $$PWD/runrecorder.cpp \
+    $$PWD/checkpointjournal.cpp \
     $$PWD/setupwizard.cpp
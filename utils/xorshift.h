@@ -0,0 +1,32 @@
+#ifndef XORSHIFT_H
+#define XORSHIFT_H
+
+#include <QtGlobal>
+
+/**
+ * Small pseudo random generator (xorshift64), reproducible from its seed.
+ */
+class XorShift
+{
+public:
+    explicit XorShift(quint64 seed = 0) { setSeed(seed); }
+
+    void setSeed(quint64 seed) { mState = seed ? seed : 0x9E3779B97F4A7C15ULL; }  // state must not be 0
+
+    quint64 next()
+    {
+        mState ^= mState << 13;
+        mState ^= mState >> 7;
+        mState ^= mState << 17;
+
+        return mState;
+    }
+
+    quint64 bounded(quint64 bound) { return bound ? next() % bound : 0; }   // 0 .. bound - 1
+    double real() { return (next() >> 11) * (1.0 / 9007199254740992.0); }  // [0, 1)
+
+private:
+    quint64 mState;
+};
+
+#endif // XORSHIFT_H